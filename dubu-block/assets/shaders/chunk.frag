@@ -8,10 +8,15 @@ in vec3  color;
 in vec2  uv0;
 in float ao;
 
+flat in vec4 tile;
+
 in vec4 fogColor;
 
 void main() {
-  vec4 texel = texture(atlas, uv0);
+  // uv0 counts blocks across the face, wrap it inside the atlas tile so merged quads repeat the
+  // texture once per block
+  vec2 tileUV = uv0 * tile.zw;
+  vec4 texel  = textureGrad(atlas, tile.xy + fract(uv0) * tile.zw, dFdx(tileUV), dFdy(tileUV));
 
   if (texel.a < 0.5) {
     discard;
@@ -1,38 +1,66 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aColor;
-layout(location = 2) in vec2 aUV0;
-layout(location = 3) in float aAO;
-
-uniform mat4  MODELVIEWPROJ;
-uniform mat4  MODEL;
-uniform mat4  MODELVIEW;
-uniform mat4  PROJ;
-uniform vec3  SKYCOLOR;
-uniform float RENDER_DISTANCE;
-uniform vec2  FOG_CONTROL;
-uniform float AGE;
+layout(location = 0) in uvec2 aVertex;
+// Per chunk, origin in xyz and creation time in w
+layout(location = 1) in vec4 aChunk;
+
+layout(std140) uniform FrameUniforms {
+  mat4  VIEW;
+  mat4  PROJ;
+  vec3  SKYCOLOR;
+  float RENDER_DISTANCE;
+  vec2  FOG_CONTROL;
+  float TIME;
+};
+
+uniform vec4 ATLAS_TILES[64];
+uniform vec3 BLOCK_COLORS[64];
+
+const float AO_STRENGTH = 0.2;
+
+// Texture axes of each face direction, in the same order as ChunkMesher::Directions
+const vec3 FACE_U[6] = vec3[6](vec3(0, 0, 1),
+                               vec3(0, 0, -1),
+                               vec3(1, 0, 0),
+                               vec3(1, 0, 0),
+                               vec3(-1, 0, 0),
+                               vec3(1, 0, 0));
+const vec3 FACE_V[6] = vec3[6](vec3(0, 1, 0),
+                               vec3(0, 1, 0),
+                               vec3(0, 0, 1),
+                               vec3(0, 0, -1),
+                               vec3(0, 1, 0),
+                               vec3(0, 1, 0));
 
 out vec3  color;
 out vec2  uv0;
 out float ao;
 
+flat out vec4 tile;
+
 out vec4 fogColor;
 
 void main() {
-  color = aColor;
-  uv0   = aUV0;
-  ao    = aAO;
+  uint geometry = aVertex.x;
+  uint material = aVertex.y;
+
+  vec3 position  = vec3(geometry & 31u, (geometry >> 5u) & 511u, (geometry >> 14u) & 31u);
+  uint face      = (geometry >> 19u) & 7u;
+  uint occlusion = (geometry >> 22u) & 3u;
+
+  color = BLOCK_COLORS[material & 255u];
+  tile  = ATLAS_TILES[(material >> 8u) & 255u];
+  uv0   = vec2(dot(position, FACE_U[face]), dot(position, FACE_V[face]));
+  ao    = 1.0 - float(occlusion) * AO_STRENGTH;
 
-  vec4  worldPos    = MODELVIEW * vec4(aPos, 1.0);
+  vec4  worldPos    = VIEW * vec4(aChunk.xyz + position, 1.0);
   float cameraDepth = length(worldPos.xyz);
   fogColor.rgb      = SKYCOLOR;
   fogColor.a        = mix(
       1.0 - exp(-(1 / FOG_CONTROL.y) * pow(cameraDepth, 2.0)) *
                 smoothstep(RENDER_DISTANCE, RENDER_DISTANCE - 16.0 * FOG_CONTROL.x, cameraDepth),
       1.0,
-      exp(-5.6 * AGE));
+      exp(-5.6 * (TIME - aChunk.w)));
 
   gl_Position = PROJ * vec4(worldPos.xyz, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// Horizontal distance from the camera inside of which the voxel chunks are drawn instead
+uniform float INNER_RADIUS;
+uniform vec3  CAMERA_POSITION;
+
+in vec3 color;
+in vec3 worldPosition;
+
+in vec4 fogColor;
+
+void main() {
+  if (length(worldPosition.xz - CAMERA_POSITION.xz) < INNER_RADIUS) {
+    discard;
+  }
+
+  FragColor = vec4(mix(color, fogColor.rgb, fogColor.a), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec4 aColor;
+
+uniform mat4  VIEW_PROJECTION;
+uniform vec3  CAMERA_POSITION;
+uniform vec3  SKYCOLOR;
+uniform vec2  FOG_CONTROL;
+uniform float HORIZON;
+
+const vec3 LIGHT_DIRECTION = normalize(vec3(0.4, 1.0, 0.3));
+
+out vec3 color;
+out vec3 worldPosition;
+
+out vec4 fogColor;
+
+void main() {
+  float light = 0.55 + 0.45 * max(dot(aNormal, LIGHT_DIRECTION), 0.0);
+  color       = aColor.rgb * light;
+
+  worldPosition     = aPosition;
+  float cameraDepth = length(aPosition - CAMERA_POSITION);
+  fogColor.rgb      = SKYCOLOR;
+  fogColor.a        = 1.0 - exp(-(1 / FOG_CONTROL.y) * pow(cameraDepth, 2.0)) *
+                         smoothstep(HORIZON, HORIZON * 0.8, cameraDepth);
+
+  gl_Position = VIEW_PROJECTION * vec4(aPosition, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 330 core
+
+// Only the source level is visible through the base and max level of the texture
+uniform sampler2D DEPTH;
+
+// Writes the farthest depth of the source texels covered by this texel of the next level. The last
+// row and column also take in the leftover texel of odd sized levels so nothing is dropped.
+void main() {
+  ivec2 sourceSize = textureSize(DEPTH, 0);
+  ivec2 targetSize = max(sourceSize / 2, ivec2(1));
+  ivec2 target     = ivec2(gl_FragCoord.xy);
+
+  ivec2 begin = target * 2;
+  ivec2 end   = min(begin + 2, sourceSize);
+  if (target.x == targetSize.x - 1) end.x = sourceSize.x;
+  if (target.y == targetSize.y - 1) end.y = sourceSize.y;
+
+  float depth = 0.0;
+  for (int y = begin.y; y < end.y; ++y) {
+    for (int x = begin.x; x < end.x; ++x) {
+      depth = max(depth, texelFetch(DEPTH, ivec2(x, y), 0).r);
+    }
+  }
+  gl_FragDepth = depth;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include <dubu_log/dubu_log.h>
 #include <dubu_rect_pack/dubu_rect_pack.hpp>
@@ -29,57 +30,36 @@ public:
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 4);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, Size, Size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    for (const auto& [id, block] : mBlockDescriptions.GetBlockDescriptions()) {
+      for (uint8_t textureIndex = 0; textureIndex < block.GetTextureCount(); ++textureIndex) {
+        LoadTexture(id, block, textureIndex);
+      }
+    }
+    glGenerateMipmap(GL_TEXTURE_2D);
   }
 
   ~Atlas() { glDeleteTextures(1, &mTexture); }
 
-  std::pair<glm::vec2, glm::vec2> GetUVs(BlockType id, glm::vec3 direction) {
+  static constexpr std::size_t MaxTiles = 64;
+
+  // Tiles are resolved from the preloaded textures only, so this is safe to call from any thread.
+  uint8_t GetTileIndex(BlockType id, glm::vec3 direction) const {
     auto&      block        = mBlockDescriptions.GetBlockDescription(id);
     const auto textureIndex = block.GetTextureIndexFromDirection(direction);
 
-    const auto key = std::make_pair(id, textureIndex);
-
-    auto it = mIdToUV.find(key);
-
-    if (it == mIdToUV.end()) {
-      int width, height, channels;
-      stbi_set_flip_vertically_on_load(true);
-
-      const auto filepath = block.GetTexturePath(textureIndex);
-
-      const auto data = stbi_load(filepath.data(), &width, &height, &channels, 4);
-      if (!data) {
-        DUBU_LOG_FATAL("Failed to load texture: {}", filepath);
-      }
-
-      const auto rect = mPacker.Pack({(unsigned int)width, (unsigned int)height});
-      if (!rect) {
-        DUBU_LOG_FATAL("Failed to fit rect into atlas!");
-      }
-
-      glBindTexture(GL_TEXTURE_2D, mTexture);
-      glTexSubImage2D(
-          GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, GL_RGBA, GL_UNSIGNED_BYTE, data);
-      glGenerateMipmap(GL_TEXTURE_2D);
-
-      stbi_image_free(data);
-
-      DUBU_LOG_DEBUG("Fit Rect into Atlas at:({},{}) with size:({},{}), texture:{}",
-                     rect->x,
-                     rect->y,
-                     rect->w,
-                     rect->h,
-                     filepath);
-      it = mIdToUV
-               .emplace(key,
-                        std::make_pair(glm::vec2(rect->x / AtlasSize.x, rect->y / AtlasSize.y),
-                                       glm::vec2(rect->w / AtlasSize.x, rect->h / AtlasSize.y)))
-               .first;
+    auto it = mIdToTile.find(std::make_pair(id, textureIndex));
+    if (it == mIdToTile.end()) {
+      DUBU_LOG_ERROR("Texture {} of block id:{} is not in the atlas", textureIndex, (int)id);
+      return 0;
     }
 
     return it->second;
   }
 
+  // Atlas rectangles as (x, y, width, height) in UV space, indexed by tile index
+  const std::vector<glm::vec4>& GetTiles() const { return mTiles; }
+
   void Bind(GLenum location) {
     glActiveTexture(location);
     glBindTexture(GL_TEXTURE_2D, mTexture);
@@ -95,8 +75,48 @@ public:
   }
 
 private:
-  dubu::rect_pack::Packer                                                  mPacker;
-  std::map<std::pair<BlockType, uint8_t>, std::pair<glm::vec2, glm::vec2>> mIdToUV;
+  void LoadTexture(BlockType id, const BlockDescription& block, uint8_t textureIndex) {
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+
+    const auto filepath = block.GetTexturePath(textureIndex);
+
+    const auto data = stbi_load(filepath.data(), &width, &height, &channels, 4);
+    if (!data) {
+      DUBU_LOG_FATAL("Failed to load texture: {}", filepath);
+    }
+
+    const auto rect = mPacker.Pack({(unsigned int)width, (unsigned int)height});
+    if (!rect) {
+      DUBU_LOG_FATAL("Failed to fit rect into atlas!");
+    }
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+    stbi_image_free(data);
+
+    DUBU_LOG_DEBUG("Fit Rect into Atlas at:({},{}) with size:({},{}), texture:{}",
+                   rect->x,
+                   rect->y,
+                   rect->w,
+                   rect->h,
+                   filepath);
+    if (mTiles.size() == MaxTiles) {
+      DUBU_LOG_FATAL("Too many textures in atlas, the limit is {}", MaxTiles);
+    }
+
+    mIdToTile.emplace(std::make_pair(id, textureIndex), static_cast<uint8_t>(mTiles.size()));
+    mTiles.emplace_back(rect->x / AtlasSize.x,
+                        rect->y / AtlasSize.y,
+                        rect->w / AtlasSize.x,
+                        rect->h / AtlasSize.y);
+  }
+
+  dubu::rect_pack::Packer                          mPacker;
+  std::map<std::pair<BlockType, uint8_t>, uint8_t> mIdToTile;
+  std::vector<glm::vec4>                           mTiles;
 
   GLuint mTexture;
 
@@ -33,6 +33,8 @@ public:
     return mCreateInfo.texturePaths[index];
   }
 
+  inline std::size_t GetTextureCount() const { return mCreateInfo.texturePaths.size(); }
+
   inline const glm::vec3& GetColor() const { return mCreateInfo.color; }
 
   inline bool IsOpaque() const { return mCreateInfo.isOpaque; }
@@ -54,6 +56,9 @@ enum class BlockType : uint8_t {
   Water     = 7,
 };
 
+// Size of the per block type lookup tables on the GPU
+static constexpr std::size_t MaxBlockTypes = 64;
+
 class BlockDescriptions {
 public:
   BlockDescriptions() {
@@ -102,6 +107,9 @@ public:
     return it->second;
   }
   const BlockDescription& GetErrorBlockDescription() const { return mErrorBlockDescription; }
+  const std::unordered_map<BlockType, BlockDescription>& GetBlockDescriptions() const {
+    return mBlockDescriptions;
+  }
 
 private:
   const BlockDescription mErrorBlockDescription{{
@@ -0,0 +1,95 @@
+#include "cave_culler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <imgui.h>
+
+namespace dubu::block {
+
+void CaveCuller::Traverse(const Frustum&      frustum,
+                          const glm::vec3&    cameraPosition,
+                          int                 renderDistance,
+                          const ChunkManager& chunkManager) {
+  mVisitedSections = 0;
+  if (!mEnabled) return;
+
+  const glm::vec2 camera{cameraPosition.x / ChunkData::ChunkSize.x,
+                         cameraPosition.z / ChunkData::ChunkSize.z};
+
+  mCenter         = glm::ivec2(glm::floor(camera));
+  mRenderDistance = renderDistance;
+  mGridSize       = renderDistance * 2 + 1;
+  mColumns.assign(mGridSize * mGridSize, {});
+  mQueue.clear();
+
+  // A camera above or below the world starts from the closest section in its column
+  const int cameraSection = std::clamp(
+      static_cast<int>(std::floor(cameraPosition.y / ChunkData::SectionHeight)),
+      0,
+      ChunkData::SectionCount - 1);
+  mQueue.push_back({{mCenter.x, cameraSection, mCenter.y}, NoFace, 0});
+  FindColumn(mCenter.x, mCenter.y)->visited |= 1u << cameraSection;
+
+  // The queue is walked breadth first without popping, so it only grows during a traversal
+  for (std::size_t i = 0; i < mQueue.size(); ++i) {
+    const auto [section, enteredFrom, directions] = mQueue[i];
+    ++mVisitedSections;
+
+    Column& column = *FindColumn(section.x, section.z);
+    if (!column.lookedUp) {
+      column.renderMesh = chunkManager.FindRenderMesh({section.x, section.z});
+      column.lookedUp   = true;
+    }
+    // Sections that are not meshed yet are treated as open so nothing behind them goes missing
+    const uint16_t connectivity = column.renderMesh
+                                      ? column.renderMesh->GetSections()[section.y].faceConnectivity
+                                      : ChunkMesher::AllFacesConnected;
+
+    for (int face = 0; face < ChunkMesher::FaceCount; ++face) {
+      if (directions & (1u << ChunkMesher::OppositeFace(face))) continue;
+      if (enteredFrom != NoFace &&
+          !(connectivity & (1u << ChunkMesher::FacePairBit(enteredFrom, face))))
+        continue;
+
+      const glm::ivec3 next = section + ChunkMesher::Directions[face];
+      if (next.y < 0 || next.y >= ChunkData::SectionCount) continue;
+
+      const float dx = (next.x + 0.5f) - camera.x;
+      const float dz = (next.z + 0.5f) - camera.y;
+      if (dx * dx + dz * dz > renderDistance * renderDistance) continue;
+
+      Column* nextColumn = FindColumn(next.x, next.z);
+      if (!nextColumn || (nextColumn->visited & (1u << next.y))) continue;
+
+      const glm::vec3 sectionMin{next.x * ChunkData::ChunkSize.x,
+                                 next.y * ChunkData::SectionHeight,
+                                 next.z * ChunkData::ChunkSize.z};
+      const glm::vec3 sectionMax = sectionMin + glm::vec3{ChunkData::ChunkSize.x,
+                                                          ChunkData::SectionHeight,
+                                                          ChunkData::ChunkSize.z};
+      if (frustum.IsOutside({sectionMin, sectionMax})) continue;
+
+      nextColumn->visited |= 1u << next.y;
+      mQueue.push_back({next,
+                        static_cast<int8_t>(ChunkMesher::OppositeFace(face)),
+                        static_cast<uint8_t>(directions | (1u << face))});
+    }
+  }
+}
+
+uint32_t CaveCuller::GetVisibleSections(ChunkCoords coords) const {
+  if (!mEnabled) return ChunkMesher::AllSections;
+
+  const int dx = coords.x - mCenter.x + mRenderDistance;
+  const int dz = coords.z - mCenter.y + mRenderDistance;
+  if (dx < 0 || dz < 0 || dx >= mGridSize || dz >= mGridSize) return 0;
+  return mColumns[dx + dz * mGridSize].visited;
+}
+
+void CaveCuller::Debug() {
+  ImGui::Checkbox("Cave Culling", &mEnabled);
+  ImGui::LabelText("Cave Culling Sections Visited", "%d", mVisitedSections);
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/chunk_data.hpp"
+#include "game/chunk_manager.hpp"
+#include "linalg/frustum.hpp"
+
+namespace dubu::block {
+
+// Finds the sections that can be seen from the camera through non-opaque blocks. Starting at the
+// section that contains the camera, neighbouring sections are flood filled, but a section is only
+// left through a face that its precomputed face connectivity joins to the face it was entered
+// through. The fill never turns back towards the camera and stays inside the frustum, so caves and
+// solid ground below the surface are never reached unless they open up towards the camera.
+class CaveCuller {
+public:
+  void Traverse(const Frustum&      frustum,
+                const glm::vec3&    cameraPosition,
+                int                 renderDistance,
+                const ChunkManager& chunkManager);
+
+  // The sections of the chunk reached by the last traversal, every section when disabled
+  uint32_t GetVisibleSections(ChunkCoords coords) const;
+
+  void Debug();
+
+private:
+  struct Column {
+    const ChunkRenderMesh* renderMesh = nullptr;
+    bool                   lookedUp   = false;
+    uint32_t               visited    = 0;
+  };
+
+  struct Step {
+    glm::ivec3 section;
+    // Face the section was entered through, NoFace for the starting section
+    int8_t enteredFrom;
+    // Directions travelled so far, the fill never goes the opposite way of any of them
+    uint8_t directions;
+  };
+
+  static constexpr int8_t NoFace = -1;
+
+  Column* FindColumn(int x, int z) {
+    const int dx = x - mCenter.x + mRenderDistance;
+    const int dz = z - mCenter.y + mRenderDistance;
+    if (dx < 0 || dz < 0 || dx >= mGridSize || dz >= mGridSize) return nullptr;
+    return &mColumns[dx + dz * mGridSize];
+  }
+
+  std::vector<Column> mColumns;
+  std::vector<Step>   mQueue;
+  glm::ivec2          mCenter          = {};
+  int                 mRenderDistance  = 0;
+  int                 mGridSize        = 0;
+  int                 mVisitedSections = 0;
+
+  bool mEnabled = true;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "chunk_culler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+namespace dubu::block {
+
+namespace {
+glm::vec2 CameraInChunks(const glm::vec3& cameraPosition) {
+  return {cameraPosition.x / ChunkData::ChunkSize.x, cameraPosition.z / ChunkData::ChunkSize.z};
+}
+
+// Number of columns whose center is within the render distance, row by row
+int CountColumnsInRange(glm::vec2 camera, glm::ivec2 center, int renderDistance) {
+  int count = 0;
+  for (int z = center.y - renderDistance; z <= center.y + renderDistance; ++z) {
+    const float dz         = (z + 0.5f) - camera.y;
+    const float halfWidth2 = static_cast<float>(renderDistance * renderDistance) - dz * dz;
+    if (halfWidth2 < 0.f) continue;
+    const float halfWidth = std::sqrt(halfWidth2);
+    const int   minX      = std::max(center.x - renderDistance,
+                                static_cast<int>(std::ceil(camera.x - halfWidth - 0.5f)));
+    const int   maxX      = std::min(center.x + renderDistance,
+                                static_cast<int>(std::floor(camera.x + halfWidth - 0.5f)));
+    count += std::max(0, maxX - minX + 1);
+  }
+  return count;
+}
+}  // namespace
+
+void ChunkCuller::Cull(const Frustum&             frustum,
+                       const glm::vec3&           cameraPosition,
+                       int                        renderDistance,
+                       std::vector<VisibleChunk>& visibleChunks) {
+  visibleChunks.clear();
+  mStats = {};
+
+  const glm::vec2  camera = CameraInChunks(cameraPosition);
+  const glm::ivec2 center{static_cast<int>(std::roundf(camera.x)),
+                          static_cast<int>(std::roundf(camera.y))};
+
+  int size = 1;
+  while (size < renderDistance * 2 + 1) size *= 2;
+
+  mStats.columnsInRange = CountColumnsInRange(camera, center, renderDistance);
+
+  CullNode(frustum,
+           camera,
+           renderDistance,
+           center - renderDistance,
+           size,
+           Frustum::Containment::Intersecting,
+           visibleChunks);
+}
+
+void ChunkCuller::CullNode(const Frustum&             frustum,
+                           glm::vec2                  camera,
+                           int                        renderDistance,
+                           glm::ivec2                 origin,
+                           int                        size,
+                           Frustum::Containment       containment,
+                           std::vector<VisibleChunk>& visibleChunks) {
+  ++mStats.nodesVisited;
+
+  // Distance from the camera to the closest chunk center in the node
+  const glm::vec2 closest =
+      glm::clamp(camera, glm::vec2(origin) + 0.5f, glm::vec2(origin + size) - 0.5f);
+
+  const glm::vec2 delta     = closest - camera;
+  const float     distance2 = glm::dot(delta, delta);
+  if (distance2 > renderDistance * renderDistance) return;
+
+  if (containment != Frustum::Containment::Inside) {
+    ++mStats.planeTests;
+    containment = frustum.Classify(ColumnsAABB(origin, size));
+    if (containment == Frustum::Containment::Outside) return;
+  }
+
+  if (size == 1) {
+    visibleChunks.push_back(
+        {{origin.x, origin.y}, distance2, containment == Frustum::Containment::Inside});
+    return;
+  }
+
+  // Visit the children closest first so the chunks come out roughly sorted by distance
+  const int                 half = size / 2;
+  std::array<glm::ivec2, 4> children{
+      origin, origin + glm::ivec2{half, 0}, origin + glm::ivec2{0, half}, origin + half};
+  std::array<float, 4> childDistances;
+  for (std::size_t i = 0; i < children.size(); ++i) {
+    const glm::vec2 childDelta = glm::vec2(children[i]) + half * 0.5f - camera;
+    childDistances[i]          = glm::dot(childDelta, childDelta);
+  }
+  std::array<std::size_t, 4> order{0, 1, 2, 3};
+  std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+    return childDistances[lhs] < childDistances[rhs];
+  });
+
+  for (const auto i : order) {
+    CullNode(frustum, camera, renderDistance, children[i], half, containment, visibleChunks);
+  }
+}
+
+void ChunkCuller::CullFlat(const Frustum&             frustum,
+                           const glm::vec3&           cameraPosition,
+                           int                        renderDistance,
+                           std::vector<VisibleChunk>& visibleChunks) {
+  visibleChunks.clear();
+  mStats = {};
+
+  const glm::vec2  camera = CameraInChunks(cameraPosition);
+  const glm::ivec2 center{static_cast<int>(std::roundf(camera.x)),
+                          static_cast<int>(std::roundf(camera.y))};
+
+  for (int z = center.y - renderDistance; z <= center.y + renderDistance; ++z) {
+    for (int x = center.x - renderDistance; x <= center.x + renderDistance; ++x) {
+      const float dx        = (x + 0.5f) - camera.x;
+      const float dz        = (z + 0.5f) - camera.y;
+      const float distance2 = dx * dx + dz * dz;
+      if (distance2 > renderDistance * renderDistance) continue;
+
+      ++mStats.columnsInRange;
+      ++mStats.planeTests;
+      if (frustum.IsOutside(ColumnsAABB({x, z}, 1))) continue;
+      visibleChunks.push_back({{x, z}, distance2, false});
+    }
+  }
+}
+
+ChunkCuller::BenchmarkResult ChunkCuller::Benchmark(const Frustum&   frustum,
+                                                    const glm::vec3& cameraPosition,
+                                                    int              renderDistance) {
+  static constexpr int Iterations = 100;
+
+  std::vector<VisibleChunk> visibleChunks;
+  BenchmarkResult           result{.renderDistance = renderDistance};
+
+  const auto t0 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < Iterations; ++i) {
+    CullFlat(frustum, cameraPosition, renderDistance, visibleChunks);
+  }
+  const auto t1 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < Iterations; ++i) {
+    Cull(frustum, cameraPosition, renderDistance, visibleChunks);
+  }
+  const auto t2 = std::chrono::high_resolution_clock::now();
+
+  result.flatMilliseconds =
+      std::chrono::duration<float, std::milli>(t1 - t0).count() / Iterations;
+  result.hierarchicalMilliseconds =
+      std::chrono::duration<float, std::milli>(t2 - t1).count() / Iterations;
+  result.visibleChunks = static_cast<int>(visibleChunks.size());
+  return result;
+}
+
+ChunkCuller::BatchBenchmarkResult ChunkCuller::BenchmarkBatch(const Frustum&   frustum,
+                                                              const AABBBatch& batch) {
+  static constexpr int Iterations = 100;
+
+  std::vector<uint32_t> perBoxMask;
+  std::vector<uint32_t> batchMask;
+  BatchBenchmarkResult  result{.boxes = static_cast<int>(batch.Size())};
+
+  const auto t0 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < Iterations; ++i) {
+    perBoxMask.assign((batch.Size() + 31) / 32, 0);
+    for (std::size_t box = 0; box < batch.Size(); ++box) {
+      if (!frustum.IsOutside(batch.Get(box))) perBoxMask[box / 32] |= 1u << (box % 32);
+    }
+  }
+  const auto t1 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < Iterations; ++i) {
+    frustum.CullBatch(batch, batchMask);
+  }
+  const auto t2 = std::chrono::high_resolution_clock::now();
+
+  result.perBoxMilliseconds =
+      std::chrono::duration<float, std::milli>(t1 - t0).count() / Iterations;
+  result.batchMilliseconds =
+      std::chrono::duration<float, std::milli>(t2 - t1).count() / Iterations;
+  for (std::size_t word = 0; word < perBoxMask.size(); ++word) {
+    result.mismatches += std::popcount(perBoxMask[word] ^ batchMask[word]);
+  }
+  return result;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/chunk_data.hpp"
+#include "linalg/aabb_batch.hpp"
+#include "linalg/frustum.hpp"
+
+namespace dubu::block {
+
+// Finds the chunk columns within the render distance that intersect the view frustum by walking a
+// quadtree over the square around the camera. Subtrees outside of the frustum or the render
+// distance are rejected at once, and subtrees fully inside the frustum skip all further plane
+// tests.
+class ChunkCuller {
+public:
+  struct VisibleChunk {
+    ChunkCoords coords;
+    // Squared distance from the camera to the chunk center, in chunks
+    float distance2;
+    // Set when the whole column is inside the frustum so its sections need no further testing
+    bool fullyInside;
+  };
+
+  struct Stats {
+    int nodesVisited = 0;
+    int planeTests   = 0;
+    // Columns within the render distance, the ones not returned are outside the frustum
+    int columnsInRange = 0;
+  };
+
+  struct BenchmarkResult {
+    int   renderDistance           = 0;
+    float flatMilliseconds         = 0.f;
+    float hierarchicalMilliseconds = 0.f;
+    int   visibleChunks            = 0;
+  };
+
+  struct BatchBenchmarkResult {
+    int   boxes              = 0;
+    float perBoxMilliseconds = 0.f;
+    float batchMilliseconds  = 0.f;
+    int   mismatches         = 0;
+  };
+
+  // Visible chunks are returned closest first
+  void Cull(const Frustum&             frustum,
+            const glm::vec3&           cameraPosition,
+            int                        renderDistance,
+            std::vector<VisibleChunk>& visibleChunks);
+
+  // Reference implementation that tests every column in range on its own
+  void CullFlat(const Frustum&             frustum,
+                const glm::vec3&           cameraPosition,
+                int                        renderDistance,
+                std::vector<VisibleChunk>& visibleChunks);
+
+  BenchmarkResult Benchmark(const Frustum&   frustum,
+                            const glm::vec3& cameraPosition,
+                            int              renderDistance);
+
+  // Compares Frustum::CullBatch against testing the boxes one by one
+  BatchBenchmarkResult BenchmarkBatch(const Frustum& frustum, const AABBBatch& batch);
+
+  const Stats& GetStats() const { return mStats; }
+
+private:
+  void CullNode(const Frustum&             frustum,
+                glm::vec2                  camera,
+                int                        renderDistance,
+                glm::ivec2                 origin,
+                int                        size,
+                Frustum::Containment       containment,
+                std::vector<VisibleChunk>& visibleChunks);
+
+  static AABB ColumnsAABB(glm::ivec2 origin, int size) {
+    return {{origin.x * ChunkData::ChunkSize.x, 0.0f, origin.y * ChunkData::ChunkSize.z},
+            {(origin.x + size) * ChunkData::ChunkSize.x,
+             ChunkData::ChunkSize.y,
+             (origin.y + size) * ChunkData::ChunkSize.z}};
+  }
+
+  Stats mStats;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "chunk_data.hpp"
+
+namespace dubu::block {
+
+ChunkData::ChunkData(const ChunkCoords chunkCoords)
+    : mChunkCoords(chunkCoords)
+    , mChunkBlockOffset({chunkCoords.x * ChunkSize.x, chunkCoords.z * ChunkSize.z}) {}
+
+void ChunkData::Compact() {
+  for (auto& section : mSections) {
+    section.Compact();
+  }
+}
+
+void ChunkData::Serialize(std::vector<uint8_t>& data) const {
+  for (const auto& section : mSections) {
+    section.Serialize(data);
+  }
+}
+
+bool ChunkData::Deserialize(std::span<const uint8_t> data) {
+  for (auto& section : mSections) {
+    if (!section.Deserialize(data)) return false;
+  }
+  return data.empty();
+}
+
+std::size_t ChunkData::GetMemoryUsage() const {
+  std::size_t memoryUsage = sizeof(ChunkData);
+  for (const auto& section : mSections) {
+    memoryUsage += section.GetMemoryUsage();
+  }
+  return memoryUsage;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/block.hpp"
+#include "game/paletted_section.hpp"
+
+namespace dubu::block {
+struct ChunkCoords {
+  int            x;
+  int            z;
+  constexpr bool operator==(const ChunkCoords& rhs) const { return x == rhs.x && z == rhs.z; }
+};
+}  // namespace dubu::block
+
+template <>
+struct std::hash<dubu::block::ChunkCoords> {
+  std::size_t operator()(const dubu::block::ChunkCoords& s) const noexcept {
+    return std::hash<int64_t>{}(static_cast<int64_t>(s.x) << 32 | s.z);
+  }
+};
+
+namespace dubu::block {
+
+// The voxel contents of a chunk column, free of any GL state so it can be created, generated and
+// queried on any thread.
+class ChunkData {
+public:
+  static constexpr glm::ivec3 ChunkSize{16, 384, 16};
+  static constexpr int        SectionHeight = 16;
+  static constexpr int        SectionCount  = ChunkSize.y / SectionHeight;
+
+  ChunkData(const ChunkCoords chunkCoords);
+
+  // Shrinks the storage of every section to the blocks it holds
+  void Compact();
+
+  BlockType GetBlockTypeAtLocalCoords(glm::ivec3 coords) const {
+    if (!AreCoordsBounded(coords)) return BlockType::Empty;
+    return mSections[coords.y / SectionHeight].Get(CoordsToSectionIndex(coords));
+  }
+  BlockType GetBlockTypeAtWorldCoords(glm::ivec3 coords) const {
+    return GetBlockTypeAtLocalCoords(WorldToLocalCoords(coords));
+  }
+  void SetBlockTypeAtLocalCoords(glm::ivec3 coords, BlockType blockType) {
+    assert(AreCoordsBounded(coords));
+    mSections[coords.y / SectionHeight].Set(CoordsToSectionIndex(coords), blockType);
+  }
+
+  // Appends the sections to data, the chunk coords are not part of it
+  void Serialize(std::vector<uint8_t>& data) const;
+  // Reads sections written by Serialize, returns false if data does not hold a whole chunk
+  bool Deserialize(std::span<const uint8_t> data);
+
+  const PalettedSection& GetSection(int sectionIndex) const { return mSections[sectionIndex]; }
+
+  std::size_t GetMemoryUsage() const;
+
+  inline glm::ivec3 LocalToWorldCoords(glm::ivec3 coords) const {
+    return {coords.x + mChunkBlockOffset.x, coords.y, coords.z + mChunkBlockOffset.z};
+  }
+  inline glm::ivec3 WorldToLocalCoords(glm::ivec3 coords) const {
+    return {coords.x - mChunkBlockOffset.x, coords.y, coords.z - mChunkBlockOffset.z};
+  }
+
+  const ChunkCoords& GetChunkCoords() const { return mChunkCoords; }
+
+  static inline std::size_t CoordsToIndex(glm::ivec3 coords) {
+    assert(AreCoordsBounded(coords));
+    return coords.x + coords.y * ChunkSize.x + coords.z * ChunkSize.x * ChunkSize.y;
+  }
+  static inline glm::ivec3 IndexToCoords(std::size_t index) {
+    assert(index < BlockCount);
+    return {index % ChunkSize.x,
+            (index / ChunkSize.x) % ChunkSize.y,
+            (index / (ChunkSize.x * ChunkSize.y))};
+  }
+  static inline bool AreCoordsBounded(glm::ivec3 coords) {
+    return coords.x >= 0 && coords.x < ChunkSize.x && coords.y >= 0 && coords.y < ChunkSize.y &&
+           coords.z >= 0 && coords.z < ChunkSize.z;
+  }
+
+  static constexpr std::size_t BlockCount = ChunkSize.x * ChunkSize.y * ChunkSize.z;
+
+private:
+  static inline std::size_t CoordsToSectionIndex(glm::ivec3 coords) {
+    return coords.x + (coords.y % SectionHeight) * ChunkSize.x +
+           coords.z * ChunkSize.x * SectionHeight;
+  }
+
+  std::array<PalettedSection, SectionCount> mSections;
+
+  const ChunkCoords mChunkCoords;
+  const ChunkCoords mChunkBlockOffset;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -1,16 +1,40 @@
 #include "chunk_manager.hpp"
 
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+
 #include <glm/gtx/norm.hpp>
 #include <imgui.h>
 
 namespace dubu::block {
 
+namespace {
+// Chunks are kept loaded this many chunks past the render distance
+constexpr int ChunkKeepMargin = 8;
+// Saved chunks go into a directory per seed in here
+constexpr const char* WorldsDirectory = "worlds";
+}  // namespace
+
 ChunkManager::ChunkManager(Atlas&                   atlas,
                            const BlockDescriptions& blockDescriptions,
-                           const Seed&              seed)
+                           const Seed&              seed,
+                           MeshArena&               meshArena)
     : mAtlas(atlas)
     , mBlockDescriptions(blockDescriptions)
-    , mSeed(seed) {}
+    , mMeshArena(meshArena)
+    , mColumnCache(seed)
+    , mPipeline(mColumnCache, mThreadPool)
+    , mChunkIo(WorldsDirectory, seed.GetSeed())
+    , mMesher(atlas, blockDescriptions) {}
+
+ChunkManager::~ChunkManager() {
+  // ChunkIo writes them before its thread stops
+  SaveChunks([](const ChunkCoords&) { return true; });
+}
 
 void ChunkManager::LoadChunk(const ChunkCoords& chunkCoords, ChunkLoadingPriority priority) {
   if (!queued.contains(chunkCoords)) {
@@ -19,20 +43,43 @@ void ChunkManager::LoadChunk(const ChunkCoords& chunkCoords, ChunkLoadingPriorit
   }
 }
 
-void ChunkManager::Update(const glm::vec3& cameraPosition, float time) {
+void ChunkManager::Update(const glm::vec3& cameraPosition, int renderDistance, float time) {
+  mCameraPosition = cameraPosition;
+
+  // Chunks being generated from the previous seed or curves are thrown away, ValidateStorage
+  // decides what happens to the loaded ones
+  if (!mColumnCache.Validate()) {
+    mPipeline.Prune([](const ChunkCoords&) { return true; });
+    ValidateStorage();
+    DropChunksToLoad();
+    InvalidateLoads();
+    queued.clear();
+  }
+  mChunkIo.Update();
+  ReceiveGeneratedChunks();
+  RemeshDirtySections();
+  ReceiveMeshes(time);
+
+  const float keepDistance = static_cast<float>(renderDistance + ChunkKeepMargin);
   if (glm::distance2(mPreviousCameraPosition, cameraPosition) > 20 * 20) {
     DUBU_LOG_DEBUG("Cleaning up chunks");
-    std::erase_if(chunks, [this, &cameraPosition](const auto& p) {
-      return ChunkDistanceFromCamera(p.first, cameraPosition) > 50 * 50;
-    });
+    const auto IsFar = [this, &cameraPosition, keepDistance](const ChunkCoords& coords) {
+      return ChunkDistanceFromCamera(coords, cameraPosition) > keepDistance * keepDistance;
+    };
+    SaveChunks(IsFar);
+    UnloadChunks(IsFar);
+    mPipeline.Prune(IsFar);
     mPreviousCameraPosition = cameraPosition;
-    chunksToLoad.clear();
-    queued.clear();
+    DropChunksToLoad();
+    InvalidateLoads();
+    std::erase_if(queued, IsFar);
   }
   if (!chunksToLoad.empty()) {
     const auto removeFrom = std::remove_if(
-        chunksToLoad.begin(), chunksToLoad.end(), [this, &cameraPosition](const auto& p) {
-          return ChunkDistanceFromCamera(p.first, cameraPosition) > 50 * 50;
+        chunksToLoad.begin(),
+        chunksToLoad.end(),
+        [this, &cameraPosition, keepDistance](const auto& p) {
+          return ChunkDistanceFromCamera(p.first, cameraPosition) > keepDistance * keepDistance;
         });
     for (auto it = removeFrom; it != chunksToLoad.end(); ++it) {
       queued.extract(it->first);
@@ -50,40 +97,396 @@ void ChunkManager::Update(const glm::vec3& cameraPosition, float time) {
                            static_cast<float>(rhs.second) * 10 * 10;
               });
 
-    const auto& [coords, priority] = chunksToLoad.back();
-    chunksToLoad.pop_back();
-
-    switch (priority) {
-    case ChunkLoadingPriority::Generate:
-      chunks.emplace(
-          coords, std::make_unique<Chunk>(coords, *this, mAtlas, mBlockDescriptions, mSeed, time));
-      break;
-    default:
-      chunks.at(coords)->Optimize();
-      break;
+    // Walk from the back so the closest chunks get the free workers
+    std::vector<std::pair<ChunkCoords, ChunkLoadingPriority>> remaining;
+    for (auto it = chunksToLoad.rbegin(); it != chunksToLoad.rend(); ++it) {
+      const auto& [coords, priority] = *it;
+
+      // Chunks that are not saved go on to the pipeline once their load comes back empty
+      const bool isUpload = priority != ChunkLoadingPriority::Generate;
+      if ((isUpload && mMeshesInFlight >= mMaxMeshesInFlight) ||
+          (!isUpload &&
+           (mChunkIo.GetPendingLoadCount() >= static_cast<std::size_t>(mMaxLoadsInFlight) ||
+            mPipeline.GetPendingCount() >= static_cast<std::size_t>(mMaxChunksInFlight)))) {
+        remaining.push_back(*it);
+        continue;
+      }
+
+      ProcessChunk(coords, priority);
+      if (isUpload) queued.extract(coords);
     }
+    chunksToLoad = std::move(remaining);
+  }
+}
+
+void ChunkManager::ReceiveGeneratedChunks() {
+  std::vector<std::unique_ptr<ChunkData>> generatedChunks;
+  mPipeline.Update(generatedChunks);
+
+  if (generatedChunks.empty()) return;
+
+  std::scoped_lock lock(mChunksMutex);
+  for (auto& chunk : generatedChunks) {
+    const auto coords = chunk->GetChunkCoords();
+    if (chunks.try_emplace(coords, std::move(chunk)).second) mUnsavedChunks.emplace(coords, false);
     queued.extract(coords);
   }
 }
 
+void ChunkManager::DropChunksToLoad() {
+  for (const auto& [coords, priority] : chunksToLoad) {
+    queued.extract(coords);
+  }
+  chunksToLoad.clear();
+}
+
+void ChunkManager::InvalidateLoads() {
+  ++mLoadGeneration;
+  for (const auto& coords : mLoadsInFlight) {
+    queued.extract(coords);
+  }
+  mLoadsInFlight.clear();
+}
+
+void ChunkManager::ValidateStorage() {
+  const int seed = mColumnCache.GetSeed()->GetSeed();
+  if (seed != mChunkIo.GetSeed()) {
+    // The loaded chunks belong to the previous seed, they are saved there before the storage
+    // switches over, and unloaded so no edit or save can reach the new one
+    SaveChunks([](const ChunkCoords&) { return true; });
+    UnloadChunks([](const ChunkCoords&) { return true; });
+    mChunkIo.SetSeed(seed);
+    return;
+  }
+
+  // Saved chunks stay as they are with the new curves, and so do edits. The chunks that were only
+  // generated are generated again from the new curves.
+  SaveChunks([this](const ChunkCoords& coords) { return mUnsavedChunks.at(coords); });
+  UnloadChunks([this](const ChunkCoords& coords) { return mUnsavedChunks.contains(coords); });
+}
+
+void ChunkManager::SaveChunks(const std::function<bool(const ChunkCoords&)>& filter) {
+  std::erase_if(mUnsavedChunks, [this, &filter](const auto& p) {
+    if (!filter(p.first)) return false;
+    if (auto chunk = FindChunk(p.first)) mChunkIo.Save(*chunk);
+    return true;
+  });
+}
+
+void ChunkManager::UnloadChunks(const std::function<bool(const ChunkCoords&)>& filter) {
+  {
+    std::scoped_lock lock(mChunksMutex);
+    std::erase_if(chunks, [&filter](const auto& p) { return filter(p.first); });
+  }
+  std::erase_if(mRenderMeshes, [this](const auto& p) { return !chunks.contains(p.first); });
+  std::erase_if(mPendingMeshes, [this](const auto& p) { return !chunks.contains(p.first); });
+  std::erase_if(mUnsavedChunks, [this](const auto& p) { return !chunks.contains(p.first); });
+}
+
+void ChunkManager::ProcessChunk(const ChunkCoords& coords, ChunkLoadingPriority priority) {
+  switch (priority) {
+  case ChunkLoadingPriority::Generate:
+    mLoadsInFlight.insert(coords);
+    mChunkIo.Load(coords, [this, coords, generation = mLoadGeneration](auto chunk) {
+      // Unloaded, cleared or from a previous seed since the load was queued
+      if (generation != mLoadGeneration) return;
+      mLoadsInFlight.erase(coords);
+      if (!chunk) {
+        mPipeline.Request(coords);
+        return;
+      }
+      {
+        std::scoped_lock lock(mChunksMutex);
+        chunks.try_emplace(coords, std::move(chunk));
+      }
+      queued.extract(coords);
+    });
+    break;
+  case ChunkLoadingPriority::Upload:
+    // The render mesh is created once the mesh comes back, chunks keep being queued until then
+    if (chunks.contains(coords) && !mRenderMeshes.contains(coords) &&
+        !mPendingMeshes.contains(coords)) {
+      RequestMesh(coords, ChunkMesher::AllSections, SelectLod(coords, -1));
+    }
+    break;
+  default:
+    if (auto it = mRenderMeshes.find(coords);
+        it != mRenderMeshes.end() && !mPendingMeshes.contains(coords)) {
+      it->second->SetOptimized();
+      RequestMesh(coords, ChunkMesher::AllSections, SelectLod(coords, it->second->GetLod()));
+    }
+    break;
+  }
+}
+
+void ChunkManager::RequestMesh(const ChunkCoords& coords, uint32_t sectionMask, int lod) {
+  auto [pending, inserted] = mPendingMeshes.try_emplace(coords);
+  // The mesh in flight is superseded, so its sections are meshed again
+  if (!inserted) sectionMask |= pending->second.sectionMask;
+  if (auto renderMesh = FindRenderMesh(coords); !renderMesh || renderMesh->GetLod() != lod) {
+    sectionMask = ChunkMesher::AllSections;
+  }
+  pending->second = {.version = ++mMeshVersion, .sectionMask = sectionMask, .lod = lod};
+  ++mMeshesInFlight;
+
+  mThreadPool.Enqueue([this, coords, sectionMask, lod, mode = mMesherMode, version = mMeshVersion] {
+    // The mesher writes straight into the staging pool of the arena
+    FinishedMesh mesh{.coords      = coords,
+                      .version     = version,
+                      .sectionMask = sectionMask,
+                      .meshData    = ChunkMesher::MeshData(&mMeshArena.GetStaging())};
+    ChunkSnapshot snapshot;
+    bool          captured;
+    {
+      std::shared_lock lock(mChunksMutex);
+      captured = CaptureSnapshot(coords, snapshot);
+    }
+    // An unloaded chunk has no pending mesh left, the empty one is thrown away
+    if (captured) mMesher.GenerateMesh(snapshot, mesh.meshData, mode, sectionMask, lod);
+
+    std::scoped_lock lock(mFinishedMeshesMutex);
+    mFinishedMeshes.push_back(std::move(mesh));
+  });
+}
+
+void ChunkManager::ReceiveMeshes(float time) {
+  {
+    std::scoped_lock lock(mFinishedMeshesMutex);
+    std::move(mFinishedMeshes.begin(), mFinishedMeshes.end(), std::back_inserter(mMeshesToApply));
+    mFinishedMeshes.clear();
+  }
+
+  mRemeshedSections = 0;
+  std::vector<FinishedMesh> remaining;
+  int                       uploads = 0;
+  for (auto& mesh : mMeshesToApply) {
+    const auto pending = mPendingMeshes.find(mesh.coords);
+    if (pending == mPendingMeshes.end() || pending->second.version != mesh.version) {
+      --mMeshesInFlight;
+      continue;
+    }
+
+    // Edits are applied right away, they only touch a few sections
+    const bool isEdit = mesh.sectionMask != ChunkMesher::AllSections;
+    if (!isEdit && uploads >= mUploadBudget) {
+      remaining.push_back(std::move(mesh));
+      continue;
+    }
+
+    auto& renderMesh = mRenderMeshes[mesh.coords];
+    if (!renderMesh) renderMesh = std::make_unique<ChunkRenderMesh>(mMeshArena, time);
+    renderMesh->Update(mesh.meshData, mesh.sectionMask);
+    if (isEdit) {
+      mRemeshedSections += std::popcount(mesh.sectionMask);
+    } else {
+      ++uploads;
+    }
+    mPendingMeshes.erase(pending);
+    --mMeshesInFlight;
+  }
+  mMeshesToApply = std::move(remaining);
+}
+
+int ChunkManager::SelectLod(const ChunkCoords& coords, int currentLod) const {
+  if (!mLodEnabled) return 0;
+
+  const auto LodAt = [this](float distance) {
+    if (distance < mLodDistance) return 0;
+    return std::min(ChunkMesher::MaxLod, static_cast<int>(std::log2(distance / mLodDistance)) + 1);
+  };
+
+  const float distance = std::sqrt(ChunkDistanceFromCamera(coords, mCameraPosition));
+  if (currentLod >= LodAt(distance - mLodHysteresis) &&
+      currentLod <= LodAt(distance + mLodHysteresis)) {
+    return currentLod;
+  }
+  return LodAt(distance);
+}
+
+bool ChunkManager::CaptureSnapshot(const ChunkCoords& coords, ChunkSnapshot& snapshot) const {
+  if (!FindChunk(coords)) return false;
+
+  ChunkSnapshot::Neighbourhood neighbourhood;
+  for (int dz = -1; dz <= 1; ++dz) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      neighbourhood[(dx + 1) + (dz + 1) * 3] = FindChunk({coords.x + dx, coords.z + dz});
+    }
+  }
+  snapshot.Capture(neighbourhood);
+  return true;
+}
+
+void ChunkManager::BenchmarkMesher() {
+  static constexpr std::size_t MaxChunkCount = 64;
+
+  MesherBenchmark benchmark{};
+  for (const auto mode : {ChunkMesher::Mode::Naive, ChunkMesher::Mode::Greedy}) {
+    std::size_t vertexCount     = 0;
+    std::size_t skippedSections = 0;
+    std::size_t chunkCount      = 0;
+
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    for (const auto& [coords, chunk] : chunks) {
+      if (chunkCount == MaxChunkCount) break;
+      CaptureSnapshot(coords, mSnapshot);
+      mMesher.GenerateMesh(mSnapshot, mMeshData, mode);
+      vertexCount += mMeshData.vertices.size();
+      skippedSections += mMeshData.skippedSections;
+      ++chunkCount;
+    }
+    const auto t1 = std::chrono::high_resolution_clock::now();
+
+    if (chunkCount == 0) return;
+
+    const auto index                      = static_cast<std::size_t>(mode);
+    benchmark.chunkCount                  = chunkCount;
+    benchmark.skippedSectionsPerChunk     = static_cast<float>(skippedSections) / chunkCount;
+    benchmark.verticesPerChunk[index]     = static_cast<float>(vertexCount) / chunkCount;
+    benchmark.millisecondsPerChunk[index] =
+        std::chrono::duration<float, std::milli>(t1 - t0).count() / chunkCount;
+  }
+  mMesherBenchmark = benchmark;
+}
+
 BlockType ChunkManager::GetBlockTypeAt(glm::ivec3 coords) const {
-  if (auto chunk = chunks.find({coords.x < 0 ? (-1 - ((-coords.x - 1) / Chunk::ChunkSize.x))
-                                             : coords.x / Chunk::ChunkSize.x,
-                                coords.z < 0 ? (-1 - ((-coords.z - 1) / Chunk::ChunkSize.z))
-                                             : coords.z / Chunk::ChunkSize.z});
-      chunk != chunks.end()) {
+  if (auto chunk = chunks.find(WorldToChunkCoords(coords)); chunk != chunks.end()) {
     return chunk->second->GetBlockTypeAtWorldCoords(coords);
   }
   return BlockType::Empty;
 }
 
+bool ChunkManager::SetBlockTypeAt(glm::ivec3 coords, BlockType blockType) {
+  if (coords.y < 0 || coords.y >= ChunkData::ChunkSize.y) return false;
+
+  auto chunk = chunks.find(WorldToChunkCoords(coords));
+  if (chunk == chunks.end()) return false;
+
+  {
+    std::scoped_lock lock(mChunksMutex);
+    chunk->second->SetBlockTypeAtLocalCoords(chunk->second->WorldToLocalCoords(coords), blockType);
+  }
+  mUnsavedChunks[chunk->first] = true;
+
+  // Faces and ambient occlusion of every block next to the edited one can change, so every
+  // section that overlaps its 3x3x3 neighbourhood needs to be remeshed.
+  for (int dz = -1; dz <= 1; ++dz) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        const glm::ivec3 neighbour = coords + glm::ivec3{dx, dy, dz};
+        if (neighbour.y < 0 || neighbour.y >= ChunkData::ChunkSize.y) continue;
+        mDirtySections[WorldToChunkCoords(neighbour)] |=
+            1u << (neighbour.y / ChunkData::SectionHeight);
+      }
+    }
+  }
+  return true;
+}
+
+void ChunkManager::RemeshDirtySections() {
+  for (const auto& [coords, sectionMask] : mDirtySections) {
+    if (!chunks.contains(coords)) continue;
+
+    // A mesh in flight may have been captured before the edit, so it is requested again
+    if (auto pending = mPendingMeshes.find(coords); pending != mPendingMeshes.end()) {
+      RequestMesh(coords, sectionMask, pending->second.lod);
+    } else if (auto renderMesh = FindRenderMesh(coords)) {
+      RequestMesh(coords, sectionMask, renderMesh->GetLod());
+    }
+    // Chunks without geometry get all of their sections meshed once they are uploaded
+  }
+  mDirtySections.clear();
+}
+
 void ChunkManager::Debug() {
-  if (ImGui::Button("Clear")) {
-    chunks.clear();
-    chunksToLoad.clear();
-    queued.clear();
+  const bool clear = ImGui::Button("Clear");
+  ImGui::SameLine();
+  // Everything is generated again, instead of loaded from the saved chunks
+  const bool deleteSaved = ImGui::Button("Clear And Delete Saved");
+  if (clear || deleteSaved) {
+    if (deleteSaved) {
+      mChunkIo.Clear();
+      mUnsavedChunks.clear();
+    }
+    SaveChunks([](const ChunkCoords&) { return true; });
+    UnloadChunks([](const ChunkCoords&) { return true; });
+    DropChunksToLoad();
+    InvalidateLoads();
   }
   ImGui::LabelText("Chunks Loaded", "%ld", chunks.size());
+
+  std::size_t blockMemory = 0;
+  for (const auto& [coords, chunk] : chunks) {
+    blockMemory += chunk->GetMemoryUsage();
+  }
+  ImGui::LabelText("Block Memory", "%.2f MB", blockMemory / (1024.f * 1024.f));
+  ImGui::LabelText("Block Memory Per Chunk",
+                   "%.2f KB",
+                   chunks.empty() ? 0.f : blockMemory / (1024.f * chunks.size()));
+
+  std::size_t meshMemory = 0;
+  for (const auto& [coords, renderMesh] : mRenderMeshes) {
+    meshMemory += renderMesh->GetMemoryUsage();
+  }
+  ImGui::LabelText("Mesh Memory", "%.2f MB", meshMemory / (1024.f * 1024.f));
+
+  std::array<int, ChunkMesher::MaxLod + 1> meshesPerLod{};
+  for (const auto& [coords, renderMesh] : mRenderMeshes) {
+    ++meshesPerLod[renderMesh->GetLod()];
+  }
+  static_assert(ChunkMesher::MaxLod == 3);
+  ImGui::LabelText("Meshes Per LOD",
+                   "%d / %d / %d / %d",
+                   meshesPerLod[0],
+                   meshesPerLod[1],
+                   meshesPerLod[2],
+                   meshesPerLod[3]);
+  ImGui::Checkbox("LOD", &mLodEnabled);
+  ImGui::SliderInt("LOD Distance", &mLodDistance, 4, 64);
+  ImGui::SliderFloat("LOD Hysteresis", &mLodHysteresis, 0.f, 8.f, "%.1f chunks");
+  ImGui::LabelText("Sections Remeshed", "%zu", mRemeshedSections);
+  ImGui::LabelText("Chunks Queued", "%ld", chunksToLoad.size());
+  mColumnCache.Debug();
+  mPipeline.Debug();
+  mChunkIo.Debug();
+  ImGui::LabelText("Unsaved Chunks", "%zu", mUnsavedChunks.size());
+  ImGui::LabelText("Chunks Generating", "%ld", mPipeline.GetPendingCount());
+  ImGui::LabelText("Meshes In Flight", "%d", mMeshesInFlight);
+  ImGui::LabelText("Worker Queue", "%ld", mThreadPool.GetQueuedJobCount());
+
+  const auto busyThreads = mThreadPool.GetBusyThreadCount();
+  const auto threadCount = mThreadPool.GetThreadCount();
+  char       workersOverlay[32];
+  std::snprintf(
+      workersOverlay, sizeof(workersOverlay), "%zu/%zu workers busy", busyThreads, threadCount);
+  ImGui::ProgressBar(static_cast<float>(busyThreads) / threadCount, {-1, 0}, workersOverlay);
+
+  ImGui::SliderInt("Upload Budget", &mUploadBudget, 1, 32);
+  ImGui::SliderInt("Max Loads In Flight", &mMaxLoadsInFlight, 1, 256);
+  ImGui::SliderInt("Max Chunks In Flight", &mMaxChunksInFlight, 1, 256);
+  ImGui::SliderInt("Max Meshes In Flight", &mMaxMeshesInFlight, 1, 256);
+
+  static constexpr const char* MesherModes[] = {"Naive", "Greedy"};
+  if (int mode = static_cast<int>(mMesherMode);
+      ImGui::Combo("Mesher", &mode, MesherModes, IM_ARRAYSIZE(MesherModes))) {
+    mMesherMode = static_cast<ChunkMesher::Mode>(mode);
+    // Drop the meshes so every chunk gets uploaded again with the new mesher
+    mRenderMeshes.clear();
+    mPendingMeshes.clear();
+  }
+  if (ImGui::Button("Benchmark Mesher")) BenchmarkMesher();
+  if (mMesherBenchmark) {
+    ImGui::LabelText("Benchmarked Chunks", "%zu", mMesherBenchmark->chunkCount);
+    ImGui::LabelText("Skipped Sections",
+                     "%.1f / %d per chunk",
+                     mMesherBenchmark->skippedSectionsPerChunk,
+                     ChunkData::SectionCount);
+    for (int i = 0; i < IM_ARRAYSIZE(MesherModes); ++i) {
+      ImGui::LabelText(MesherModes[i],
+                       "%.0f vertices, %.2fms per chunk",
+                       mMesherBenchmark->verticesPerChunk[i],
+                       mMesherBenchmark->millisecondsPerChunk[i]);
+    }
+  }
 }
 
 }  // namespace dubu::block
@@ -1,52 +1,174 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 
-#include "chunk.hpp"
+#include "game/chunk_data.hpp"
+#include "game/chunk_mesher.hpp"
+#include "game/chunk_render_mesh.hpp"
+#include "game/chunk_snapshot.hpp"
+#include "game/column_cache.hpp"
+#include "game/generation_pipeline.hpp"
 #include "generator/seed.hpp"
+#include "gl/mesh_arena.hpp"
+#include "io/chunk_io.hpp"
+#include "util/thread_pool.hpp"
 
 namespace dubu::block {
 
 class ChunkManager {
 public:
-  enum class ChunkLoadingPriority { Update, Generate, Optimize };
+  enum class ChunkLoadingPriority { Update, Upload, Generate, Optimize };
 
-  ChunkManager(Atlas& atlas, const BlockDescriptions& blockDescriptions, const Seed& seed);
+  ChunkManager(Atlas&                   atlas,
+               const BlockDescriptions& blockDescriptions,
+               const Seed&              seed,
+               MeshArena&               meshArena);
+  // Saves the chunks that were generated or edited since they were loaded
+  ~ChunkManager();
 
   void LoadChunk(const ChunkCoords& chunkCoords, ChunkLoadingPriority priority);
 
-  void Update(const glm::vec3& cameraPosition, float time);
+  // Chunks further than a few chunks beyond renderDistance are unloaded
+  void Update(const glm::vec3& cameraPosition, int renderDistance, float time);
 
-  const Chunk* FindChunk(const ChunkCoords& chunkCoords) const {
+  const ChunkData* FindChunk(const ChunkCoords& chunkCoords) const {
     if (auto chunk = chunks.find(chunkCoords); chunk != chunks.end()) return chunk->second.get();
     return nullptr;
   }
+  const ChunkRenderMesh* FindRenderMesh(const ChunkCoords& chunkCoords) const {
+    if (auto it = mRenderMeshes.find(chunkCoords); it != mRenderMeshes.end())
+      return it->second.get();
+    return nullptr;
+  }
+
+  // The level of detail the chunk should be meshed at from the camera position of the last Update.
+  // A chunk keeps currentLod until it is a few chunks past the distance where the level changes,
+  // so chunks near that distance are not remeshed back and forth. -1 means no current level.
+  int SelectLod(const ChunkCoords& coords, int currentLod) const;
 
   BlockType GetBlockTypeAt(glm::ivec3 coords) const;
+  // Edits are sent to the workers once per frame in Update, only the sections the edit can affect
+  // are remeshed, and saved once the chunk is unloaded. Returns false if the chunk is not loaded.
+  bool SetBlockTypeAt(glm::ivec3 coords, BlockType blockType);
 
   void Debug();
 
 private:
+  void ReceiveGeneratedChunks();
+  // Drops the chunks waiting to be processed, the ones being loaded or generated stay queued
+  void DropChunksToLoad();
+  // Drops the loads in flight, their chunks are queued again when they are next wanted
+  void InvalidateLoads();
+  void ValidateStorage();
+  void SaveChunks(const std::function<bool(const ChunkCoords&)>& filter);
+  // Unsaved chunks are lost, save them first to keep them
+  void UnloadChunks(const std::function<bool(const ChunkCoords&)>& filter);
+  void ProcessChunk(const ChunkCoords& coords, ChunkLoadingPriority priority);
+  // Meshes the chunk on a worker, replacing the request in flight for it. Only a mesh at the level
+  // of detail of the current geometry can be partial, others get all of their sections meshed.
+  void RequestMesh(const ChunkCoords& coords, uint32_t sectionMask, int lod);
+  // Applies the meshes the workers finished, the ones of new or remeshed chunks up to the upload
+  // budget
+  void ReceiveMeshes(float time);
+  // Returns false if the chunk is not loaded
+  bool CaptureSnapshot(const ChunkCoords& coords, ChunkSnapshot& snapshot) const;
+  void RemeshDirtySections();
+  void BenchmarkMesher();
+
+  static inline ChunkCoords WorldToChunkCoords(glm::ivec3 coords) {
+    return {coords.x < 0 ? (-1 - ((-coords.x - 1) / ChunkData::ChunkSize.x))
+                         : coords.x / ChunkData::ChunkSize.x,
+            coords.z < 0 ? (-1 - ((-coords.z - 1) / ChunkData::ChunkSize.z))
+                         : coords.z / ChunkData::ChunkSize.z};
+  }
+
   inline float ChunkDistanceFromCamera(const ChunkCoords& coords,
                                        const glm::vec3&   cameraPosition) const {
-    const float dx = (coords.x + 0.5f) - cameraPosition.x / (float)(Chunk::ChunkSize.x);
-    const float dz = (coords.z + 0.5f) - cameraPosition.z / (float)(Chunk::ChunkSize.z);
+    const float dx = (coords.x + 0.5f) - cameraPosition.x / (float)(ChunkData::ChunkSize.x);
+    const float dz = (coords.z + 0.5f) - cameraPosition.z / (float)(ChunkData::ChunkSize.z);
     const float d  = dx * dx + dz * dz;
     return d;
   }
 
-  std::unordered_map<ChunkCoords, std::unique_ptr<Chunk>>   chunks;
-  std::vector<std::pair<ChunkCoords, ChunkLoadingPriority>> chunksToLoad;
-  std::unordered_set<ChunkCoords>                           queued;
+  std::unordered_map<ChunkCoords, std::unique_ptr<ChunkData>> chunks;
+  std::vector<std::pair<ChunkCoords, ChunkLoadingPriority>>   chunksToLoad;
+  std::unordered_set<ChunkCoords>                             queued;
+  std::unordered_set<ChunkCoords>                             mLoadsInFlight;
+  // Load callbacks from before the last InvalidateLoads are ignored
+  uint32_t mLoadGeneration = 0;
+
+  // The workers read chunks while meshing, the main thread holds it exclusively to change them
+  std::shared_mutex mChunksMutex;
+
+  struct PendingMesh {
+    uint32_t version;
+    uint32_t sectionMask;
+    int      lod;
+  };
+  struct FinishedMesh {
+    ChunkCoords           coords;
+    uint32_t              version;
+    uint32_t              sectionMask;
+    ChunkMesher::MeshData meshData;
+  };
+
+  std::unordered_map<ChunkCoords, std::unique_ptr<ChunkRenderMesh>> mRenderMeshes;
+  std::unordered_map<ChunkCoords, uint32_t>                         mDirtySections;
+  std::size_t                                                       mRemeshedSections = 0;
+  // Finished meshes whose version is not the pending one of their chunk are thrown away
+  std::unordered_map<ChunkCoords, PendingMesh> mPendingMeshes;
+  uint32_t                                     mMeshVersion    = 0;
+  int                                          mMeshesInFlight = 0;
+  std::vector<FinishedMesh>                    mMeshesToApply;
+  std::vector<FinishedMesh>                    mFinishedMeshes;
+  std::mutex                                   mFinishedMeshesMutex;
+
+  // Loaded chunks that differ from the saved ones, and whether they were edited or only generated
+  std::unordered_map<ChunkCoords, bool> mUnsavedChunks;
+
+  int mUploadBudget      = 4;
+  int mMaxLoadsInFlight  = 64;
+  int mMaxChunksInFlight = 64;
+  int mMaxMeshesInFlight = 64;
+
+  // Chunks closer than mLodDistance are meshed at full resolution, every doubling of the distance
+  // halves the resolution again
+  bool  mLodEnabled    = true;
+  int   mLodDistance   = 16;
+  float mLodHysteresis = 2.f;
 
   Atlas&                   mAtlas;
   const BlockDescriptions& mBlockDescriptions;
-  const Seed&              mSeed;
+  MeshArena&               mMeshArena;
+  ColumnCache              mColumnCache;
+  GenerationPipeline       mPipeline;
+  ChunkIo                  mChunkIo;
+
+  ChunkMesher       mMesher;
+  ChunkMesher::Mode mMesherMode = ChunkMesher::Mode::Greedy;
+  // Only used by the benchmark, chunks are meshed on the workers
+  ChunkSnapshot         mSnapshot;
+  ChunkMesher::MeshData mMeshData;
+
+  struct MesherBenchmark {
+    std::size_t chunkCount;
+    float       skippedSectionsPerChunk;
+    float       verticesPerChunk[2];
+    float       millisecondsPerChunk[2];
+  };
+  std::optional<MesherBenchmark> mMesherBenchmark;
 
   glm::vec3 mPreviousCameraPosition;
+  glm::vec3 mCameraPosition = {};
+
+  // Declared last so the workers are joined before anything they touch is destroyed
+  ThreadPool mThreadPool;
 };
 
 }  // namespace dubu::block
\ No newline at end of file
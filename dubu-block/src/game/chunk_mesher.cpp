@@ -0,0 +1,340 @@
+#include "chunk_mesher.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <vector>
+
+#include "game/downsampled_snapshot.hpp"
+
+namespace dubu::block {
+
+void ChunkMesher::GenerateMesh(const ChunkSnapshot& snapshot,
+                               MeshData&            meshData,
+                               Mode                 mode,
+                               uint32_t             sectionMask,
+                               int                  lod) const {
+  meshData.vertices.clear();
+  meshData.indices.clear();
+
+  meshData.skippedSections = 0;
+  meshData.lod             = lod;
+
+  DownsampledSnapshot downsampled;
+  if (lod > 0) downsampled.Capture(snapshot, lod, mBlockDescriptions);
+  const int scale = 1 << lod;
+
+  for (int sectionIndex = 0; sectionIndex < ChunkData::SectionCount; ++sectionIndex) {
+    auto& section = meshData.sections[sectionIndex];
+    section       = {.firstVertex = static_cast<GLint>(meshData.vertices.size()),
+                     .firstIndex  = static_cast<GLuint>(meshData.indices.size())};
+
+    if (!(sectionMask & (1u << sectionIndex))) continue;
+    section.faceConnectivity = ComputeFaceConnectivity(snapshot, sectionIndex);
+    // Downsampled cells can reach into neighbouring sections, so only empty sections are known to
+    // have no faces
+    const bool skip = lod == 0 ? CanSkipSection(snapshot, sectionIndex)
+                               : snapshot.GetUniformBlockType(sectionIndex) == BlockType::Empty;
+    if (skip) {
+      ++meshData.skippedSections;
+      continue;
+    }
+
+    // The box of the section in cells of the meshed volume
+    const glm::ivec3 boxMin{0, sectionIndex * ChunkData::SectionHeight / scale, 0};
+    const glm::ivec3 boxSize{ChunkData::ChunkSize.x / scale,
+                             ChunkData::SectionHeight / scale,
+                             ChunkData::ChunkSize.z / scale};
+    section.min = (boxMin + boxSize) * scale;
+    section.max = boxMin * scale;
+    switch (mode) {
+    case Mode::Naive:
+      if (lod > 0) {
+        GenerateNaiveMesh(downsampled, boxMin, boxSize, scale, meshData, section);
+      } else {
+        GenerateNaiveMesh(snapshot, boxMin, boxSize, scale, meshData, section);
+      }
+      break;
+    case Mode::Greedy:
+      if (lod > 0) {
+        GenerateGreedyMesh(downsampled, boxMin, boxSize, scale, meshData, section);
+      } else {
+        GenerateGreedyMesh(snapshot, boxMin, boxSize, scale, meshData, section);
+      }
+      break;
+    }
+
+    section.vertexCount = static_cast<GLsizei>(meshData.vertices.size() - section.firstVertex);
+    section.indexCount  = static_cast<GLsizei>(meshData.indices.size() - section.firstIndex);
+    if (section.indexCount == 0) {
+      section.min = {};
+      section.max = {};
+    }
+  }
+}
+
+bool ChunkMesher::CanSkipSection(const ChunkSnapshot& snapshot, int sectionIndex) const {
+  const auto uniformBlockType = snapshot.GetUniformBlockType(sectionIndex);
+  if (!uniformBlockType) return false;
+
+  const auto blockType = *uniformBlockType;
+  if (blockType == BlockType::Empty) return true;
+  if (!IsOpaque(blockType)) return false;
+
+  // A uniform solid section can only have faces on its boundary, so it is invisible when every
+  // block around it is opaque as well. Sections are cubes, so one loop covers all six sides.
+  static_assert(ChunkData::ChunkSize.x == ChunkData::SectionHeight &&
+                ChunkData::ChunkSize.z == ChunkData::SectionHeight);
+  const int y0 = sectionIndex * ChunkData::SectionHeight;
+  const int y1 = y0 + ChunkData::SectionHeight;
+  for (int i = 0; i < ChunkData::SectionHeight; ++i) {
+    for (int j = 0; j < ChunkData::SectionHeight; ++j) {
+      if (!IsOpaque(snapshot.Get({-1, y0 + i, j})) ||
+          !IsOpaque(snapshot.Get({ChunkData::ChunkSize.x, y0 + i, j})) ||
+          !IsOpaque(snapshot.Get({j, y0 + i, -1})) ||
+          !IsOpaque(snapshot.Get({j, y0 + i, ChunkData::ChunkSize.z})) ||
+          !IsOpaque(snapshot.Get({i, y0 - 1, j})) || !IsOpaque(snapshot.Get({i, y1, j}))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+uint16_t ChunkMesher::ComputeFaceConnectivity(const ChunkSnapshot& snapshot,
+                                              int                  sectionIndex) const {
+  if (const auto uniformBlockType = snapshot.GetUniformBlockType(sectionIndex)) {
+    return IsOpaque(*uniformBlockType) ? 0 : AllFacesConnected;
+  }
+
+  // Flood fill every region of non-opaque blocks and connect all faces of the section it touches
+  constexpr int Size = ChunkData::SectionHeight;
+  const int     y0   = sectionIndex * Size;
+
+  std::bitset<Size * Size * Size> visited;
+  std::vector<glm::ivec3>         stack;
+  uint16_t                        connectivity = 0;
+
+  for (int y = 0; y < Size; ++y) {
+    for (int z = 0; z < Size; ++z) {
+      for (int x = 0; x < Size; ++x) {
+        if (visited[x + z * Size + y * Size * Size] || IsOpaque(snapshot.Get({x, y0 + y, z})))
+          continue;
+
+        uint8_t faces = 0;
+        stack.push_back({x, y, z});
+        visited.set(x + z * Size + y * Size * Size);
+        while (!stack.empty()) {
+          const glm::ivec3 coords = stack.back();
+          stack.pop_back();
+
+          for (int d = 0; d < FaceCount; ++d) {
+            const glm::ivec3 next = coords + Directions[d];
+            if (next.x < 0 || next.y < 0 || next.z < 0 || next.x >= Size || next.y >= Size ||
+                next.z >= Size) {
+              faces |= 1u << d;
+              continue;
+            }
+
+            const int index = next.x + next.z * Size + next.y * Size * Size;
+            if (visited[index] || IsOpaque(snapshot.Get({next.x, y0 + next.y, next.z}))) continue;
+            visited.set(index);
+            stack.push_back(next);
+          }
+        }
+
+        for (int a = 0; a < FaceCount; ++a) {
+          for (int b = a + 1; b < FaceCount; ++b) {
+            if ((faces & (1u << a)) && (faces & (1u << b))) connectivity |= 1u << FacePairBit(a, b);
+          }
+        }
+        if (connectivity == AllFacesConnected) return connectivity;
+      }
+    }
+  }
+  return connectivity;
+}
+
+template <typename Volume>
+void ChunkMesher::GenerateNaiveMesh(const Volume& volume,
+                                    glm::ivec3    boxMin,
+                                    glm::ivec3    boxSize,
+                                    int           scale,
+                                    MeshData&     meshData,
+                                    SectionRange& section) const {
+  for (int z = boxMin.z; z < boxMin.z + boxSize.z; ++z) {
+    for (int y = boxMin.y; y < boxMin.y + boxSize.y; ++y) {
+      for (int x = boxMin.x; x < boxMin.x + boxSize.x; ++x) {
+        const glm::ivec3 myCoord{x, y, z};
+        const auto       blockType = volume.Get(myCoord);
+
+        if (blockType == BlockType::Empty) continue;
+
+        for (std::size_t d = 0; d < Directions.size(); ++d) {
+          FaceOcclusion occlusion;
+          if (!IsFaceVisible(volume, myCoord, d, occlusion)) continue;
+
+          EmitFace(meshData, section, d, blockType, myCoord, {1, 1, 1}, scale, occlusion);
+        }
+      }
+    }
+  }
+}
+
+template <typename Volume>
+void ChunkMesher::GenerateGreedyMesh(const Volume& volume,
+                                     glm::ivec3    boxMin,
+                                     glm::ivec3    boxSize,
+                                     int           scale,
+                                     MeshData&     meshData,
+                                     SectionRange& section) const {
+  // A face is identified by its block type and the occlusion of its four vertices, only faces
+  // with identical keys are merged. Faces whose occlusion differs stay separate quads.
+  const auto PackKey = [](BlockType blockType, const FaceOcclusion& occlusion) -> uint32_t {
+    return static_cast<uint32_t>(blockType) << 8 | occlusion[0] | occlusion[1] << 2 |
+           occlusion[2] << 4 | occlusion[3] << 6;
+  };
+
+  std::vector<uint32_t> mask;
+
+  for (std::size_t d = 0; d < Directions.size(); ++d) {
+    const int axis  = Directions[d].x != 0 ? 0 : (Directions[d].y != 0 ? 1 : 2);
+    const int u     = (axis + 1) % 3;
+    const int v     = (axis + 2) % 3;
+    const int sizeU = boxSize[u];
+    const int sizeV = boxSize[v];
+    mask.resize(sizeU * sizeV);
+
+    for (int slice = boxMin[axis]; slice < boxMin[axis] + boxSize[axis]; ++slice) {
+      glm::ivec3 coords;
+      coords[axis] = slice;
+      for (int j = 0; j < sizeV; ++j) {
+        for (int i = 0; i < sizeU; ++i) {
+          coords[u] = boxMin[u] + i;
+          coords[v] = boxMin[v] + j;
+
+          auto& key = mask[i + j * sizeU];
+          key       = 0;
+
+          const auto    blockType = volume.Get(coords);
+          FaceOcclusion occlusion;
+          if (blockType == BlockType::Empty || !IsFaceVisible(volume, coords, d, occlusion))
+            continue;
+
+          key = PackKey(blockType, occlusion);
+        }
+      }
+
+      for (int j = 0; j < sizeV; ++j) {
+        for (int i = 0; i < sizeU;) {
+          const uint32_t key = mask[i + j * sizeU];
+          if (key == 0) {
+            ++i;
+            continue;
+          }
+
+          int width = 1;
+          while (i + width < sizeU && mask[i + width + j * sizeU] == key) ++width;
+
+          int height = 1;
+          for (; j + height < sizeV; ++height) {
+            const auto row = mask.begin() + i + (j + height) * sizeU;
+            if (std::any_of(row, row + width, [key](uint32_t k) { return k != key; })) break;
+          }
+
+          for (int row = 0; row < height; ++row) {
+            std::fill_n(mask.begin() + i + (j + row) * sizeU, width, 0u);
+          }
+
+          glm::ivec3 origin, extent;
+          origin[axis] = slice;
+          origin[u]    = boxMin[u] + i;
+          origin[v]    = boxMin[v] + j;
+          extent[axis] = 1;
+          extent[u]    = width;
+          extent[v]    = height;
+
+          const FaceOcclusion occlusion{static_cast<uint8_t>(key & 3),
+                                        static_cast<uint8_t>((key >> 2) & 3),
+                                        static_cast<uint8_t>((key >> 4) & 3),
+                                        static_cast<uint8_t>((key >> 6) & 3)};
+          EmitFace(meshData,
+                   section,
+                   d,
+                   static_cast<BlockType>(key >> 8),
+                   origin,
+                   extent,
+                   scale,
+                   occlusion);
+
+          i += width;
+        }
+      }
+    }
+  }
+}
+
+template <typename Volume>
+bool ChunkMesher::IsFaceVisible(const Volume&  volume,
+                                glm::ivec3     coords,
+                                std::size_t    direction,
+                                FaceOcclusion& occlusion) const {
+  const auto otherBlockType = volume.Get(coords + Directions[direction]);
+  if (otherBlockType != BlockType::Empty) {
+    if (IsOpaque(otherBlockType)) return false;
+
+    occlusion = {3, 3, 3, 3};
+    return true;
+  }
+
+  const auto&   aoNeighbours = DirectionToFace[direction].aoNeighbours;
+  const uint8_t n0           = !volume.IsEmpty(coords + aoNeighbours[0]);
+  const uint8_t n1           = !volume.IsEmpty(coords + aoNeighbours[1]);
+  const uint8_t n2           = !volume.IsEmpty(coords + aoNeighbours[2]);
+  const uint8_t n3           = !volume.IsEmpty(coords + aoNeighbours[3]);
+  const uint8_t n4           = !volume.IsEmpty(coords + aoNeighbours[4]);
+  const uint8_t n5           = !volume.IsEmpty(coords + aoNeighbours[5]);
+  const uint8_t n6           = !volume.IsEmpty(coords + aoNeighbours[6]);
+  const uint8_t n7           = !volume.IsEmpty(coords + aoNeighbours[7]);
+
+  occlusion = {static_cast<uint8_t>(n0 + n1 + n2),
+               static_cast<uint8_t>(n2 + n3 + n4),
+               static_cast<uint8_t>(n4 + n5 + n6),
+               static_cast<uint8_t>(n6 + n7 + n0)};
+  return true;
+}
+
+void ChunkMesher::EmitFace(MeshData&            meshData,
+                           SectionRange&        section,
+                           std::size_t          direction,
+                           BlockType            blockType,
+                           glm::ivec3           origin,
+                           glm::ivec3           extent,
+                           int                  scale,
+                           const FaceOcclusion& occlusion) const {
+  const auto& faceData  = DirectionToFace[direction];
+  const auto  tileIndex = mAtlas.GetTileIndex(blockType, Directions[direction]);
+
+  // UVs and colors are derived in chunk.vert from the face direction, the position and the
+  // material lookups
+  const uint32_t material =
+      static_cast<uint32_t>(blockType) | static_cast<uint32_t>(tileIndex) << 8;
+
+  const auto startIndex = static_cast<GLuint>(meshData.vertices.size() - section.firstVertex);
+  for (std::size_t i = 0; i < faceData.vertices.size(); ++i) {
+    const glm::ivec3 position = (origin + glm::ivec3(faceData.vertices[i]) * extent) * scale;
+    section.min               = glm::min(section.min, position);
+    section.max               = glm::max(section.max, position);
+
+    meshData.vertices.push_back(
+        {.geometry = static_cast<uint32_t>(position.x) | static_cast<uint32_t>(position.y) << 5 |
+                     static_cast<uint32_t>(position.z) << 14 |
+                     static_cast<uint32_t>(direction) << 19 |
+                     static_cast<uint32_t>(occlusion[i]) << 22,
+         .material = material});
+  }
+  for (const auto index : faceData.indices) {
+    meshData.indices.push_back(startIndex + index);
+  }
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "game/atlas.hpp"
+#include "game/block.hpp"
+#include "game/chunk_data.hpp"
+#include "game/chunk_snapshot.hpp"
+#include "game/chunk_vertex.hpp"
+#include "gl/staging_stream.hpp"
+
+namespace dubu::block {
+
+// Builds the vertex and index data for a chunk on the CPU. Does not touch any GL state and only
+// reads from the given snapshot, so it is safe to run on any thread. The geometry is written
+// straight into the staging pool of the MeshData, without an intermediate copy.
+class ChunkMesher {
+public:
+  // Naive emits one quad per visible face, Greedy merges coplanar faces that share block type and
+  // ambient occlusion into larger quads.
+  enum class Mode { Naive, Greedy };
+
+  static constexpr uint32_t AllSections = (1ull << ChunkData::SectionCount) - 1;
+
+  static constexpr int                               FaceCount = 6;
+  static constexpr std::array<glm::ivec3, FaceCount> Directions{{
+      {-1, 0, 0},  // Left
+      {1, 0, 0},   // Right
+      {0, -1, 0},  // Down
+      {0, 1, 0},   // Up
+      {0, 0, -1},  // Back
+      {0, 0, 1},   // Front
+  }};
+
+  // Faces are numbered like Directions, 15 pairs of them fit in SectionRange::faceConnectivity
+  static constexpr uint16_t AllFacesConnected = (1u << 15) - 1;
+
+  // Bit of the face pair a, b in SectionRange::faceConnectivity
+  static constexpr int FacePairBit(int a, int b) {
+    if (a > b) std::swap(a, b);
+    return a * (11 - a) / 2 + (b - a - 1);
+  }
+  static constexpr int OppositeFace(int face) { return face ^ 1; }
+
+  // Vertex and index range and local block bounds of the geometry of one 16x16x16 section. The
+  // indices are relative to the first vertex of the section so ranges can be moved around freely.
+  // faceConnectivity has a bit per pair of faces that are connected through non-opaque blocks.
+  struct SectionRange {
+    GLint      firstVertex      = 0;
+    GLsizei    vertexCount      = 0;
+    GLuint     firstIndex       = 0;
+    GLsizei    indexCount       = 0;
+    glm::ivec3 min              = {};
+    glm::ivec3 max              = {};
+    uint16_t   faceConnectivity = 0;
+  };
+
+  struct MeshData {
+    MeshData(StagingPool* staging = nullptr)
+        : vertices(staging)
+        , indices(staging) {}
+
+    StagingStream<ChunkVertex>                        vertices;
+    StagingStream<GLuint>                             indices;
+    std::array<SectionRange, ChunkData::SectionCount> sections;
+    std::size_t                                       skippedSections = 0;
+    int                                               lod             = 0;
+  };
+
+  // Levels of detail mesh cells of 2^lod blocks per axis
+  static constexpr int MaxLod = 3;
+
+  ChunkMesher(const Atlas& atlas, const BlockDescriptions& blockDescriptions)
+      : mAtlas(atlas)
+      , mBlockDescriptions(blockDescriptions) {}
+
+  // Only the sections in sectionMask are meshed, the ranges of the others are left empty. Above
+  // lod 0 the chunk is meshed from a DownsampledSnapshot of the given snapshot.
+  void GenerateMesh(const ChunkSnapshot& snapshot,
+                    MeshData&            meshData,
+                    Mode                 mode        = Mode::Naive,
+                    uint32_t             sectionMask = AllSections,
+                    int                  lod         = 0) const;
+
+private:
+  // Number of occluding neighbours (0-3) for each of the four face vertices
+  using FaceOcclusion = std::array<uint8_t, 4>;
+
+  bool     CanSkipSection(const ChunkSnapshot& snapshot, int sectionIndex) const;
+  uint16_t ComputeFaceConnectivity(const ChunkSnapshot& snapshot, int sectionIndex) const;
+
+  // Volume is a ChunkSnapshot or a DownsampledSnapshot, scale the number of blocks per cell
+  // Faces are added to meshData and the vertex range and bounds of section
+  template <typename Volume>
+  void GenerateNaiveMesh(const Volume& volume,
+                         glm::ivec3    boxMin,
+                         glm::ivec3    boxSize,
+                         int           scale,
+                         MeshData&     meshData,
+                         SectionRange& section) const;
+  template <typename Volume>
+  void GenerateGreedyMesh(const Volume& volume,
+                          glm::ivec3    boxMin,
+                          glm::ivec3    boxSize,
+                          int           scale,
+                          MeshData&     meshData,
+                          SectionRange& section) const;
+
+  bool IsOpaque(BlockType blockType) const {
+    return blockType != BlockType::Empty &&
+           mBlockDescriptions.GetBlockDescription(blockType).IsOpaque();
+  }
+
+  template <typename Volume>
+  bool IsFaceVisible(const Volume&  volume,
+                     glm::ivec3     coords,
+                     std::size_t    direction,
+                     FaceOcclusion& occlusion) const;
+
+  // The indices are relative to the first vertex of section, which is never read back
+  void EmitFace(MeshData&            meshData,
+                SectionRange&        section,
+                std::size_t          direction,
+                BlockType            blockType,
+                glm::ivec3           origin,
+                glm::ivec3           extent,
+                int                  scale,
+                const FaceOcclusion& occlusion) const;
+
+  struct FaceData {
+    std::array<glm::vec3, 4>    vertices;
+    std::array<glm::ivec3, 8>   aoNeighbours;
+    std::array<unsigned int, 6> indices;
+  };
+
+  static constexpr std::array<FaceData, 6> DirectionToFace{{
+      // Left
+      {{
+           glm::vec3{0.f, 1.f, 0.f},
+           glm::vec3{0.f, 1.f, 1.f},
+           glm::vec3{0.f, 0.f, 1.f},
+           glm::vec3{0.f, 0.f, 0.f},
+       },
+         {{{-1, 0, -1},
+           {-1, 1, -1},
+           {-1, 1, 0},
+           {-1, 1, 1},
+           {-1, 0, 1},
+           {-1, -1, 1},
+           {-1, -1, 0},
+           {-1, -1, -1}}},
+         {0, 1, 2, 0, 2, 3}},
+      // Right
+      {{
+           glm::vec3{1.f, 1.f, 1.f},
+           glm::vec3{1.f, 1.f, 0.f},
+           glm::vec3{1.f, 0.f, 0.f},
+           glm::vec3{1.f, 0.f, 1.f},
+       },
+         {{{1, 0, 1},
+           {1, 1, 1},
+           {1, 1, 0},
+           {1, 1, -1},
+           {1, 0, -1},
+           {1, -1, -1},
+           {1, -1, 0},
+           {1, -1, 1}}},
+         {0, 1, 2, 0, 2, 3}},
+      // Down
+      {{
+           glm::vec3{0.f, 0.f, 1.f},
+           glm::vec3{1.f, 0.f, 1.f},
+           glm::vec3{1.f, 0.f, 0.f},
+           glm::vec3{0.f, 0.f, 0.f},
+       },
+         {{{-1, -1, 0},
+           {-1, -1, 1},
+           {0, -1, 1},
+           {1, -1, 1},
+           {1, -1, 0},
+           {1, -1, -1},
+           {0, -1, -1},
+           {-1, -1, -1}}},
+         {0, 1, 2, 0, 2, 3}},
+      // Up
+      {{
+           glm::vec3{0.f, 1.f, 0.f},
+           glm::vec3{1.f, 1.f, 0.f},
+           glm::vec3{1.f, 1.f, 1.f},
+           glm::vec3{0.f, 1.f, 1.f},
+       },
+         {{{-1, 1, 0},
+           {-1, 1, -1},
+           {0, 1, -1},
+           {1, 1, -1},
+           {1, 1, 0},
+           {1, 1, 1},
+           {0, 1, 1},
+           {-1, 1, 1}}},
+         {0, 1, 2, 0, 2, 3}},
+      // Back
+      {{
+           glm::vec3{1.f, 1.f, 0.f},
+           glm::vec3{0.f, 1.f, 0.f},
+           glm::vec3{0.f, 0.f, 0.f},
+           glm::vec3{1.f, 0.f, 0.f},
+       },
+         {{{1, 0, -1},
+           {1, 1, -1},
+           {0, 1, -1},
+           {-1, 1, -1},
+           {-1, 0, -1},
+           {-1, -1, -1},
+           {0, -1, -1},
+           {1, -1, -1}}},
+         {0, 1, 2, 0, 2, 3}},
+      // Front
+      {{
+           glm::vec3{0.f, 1.f, 1.f},
+           glm::vec3{1.f, 1.f, 1.f},
+           glm::vec3{1.f, 0.f, 1.f},
+           glm::vec3{0.f, 0.f, 1.f},
+       },
+         {{{-1, 0, 1},
+           {-1, 1, 1},
+           {0, 1, 1},
+           {1, 1, 1},
+           {1, 0, 1},
+           {1, -1, 1},
+           {0, -1, 1},
+           {-1, -1, 1}}},
+         {0, 1, 2, 0, 2, 3}},
+  }};
+
+  const Atlas&             mAtlas;
+  const BlockDescriptions& mBlockDescriptions;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
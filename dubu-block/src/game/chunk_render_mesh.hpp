@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "game/chunk_mesher.hpp"
+#include "gl/mesh_arena.hpp"
+
+namespace dubu::block {
+
+// The GPU resident geometry of a chunk, owned by the ChunkManager next to its ChunkData. The
+// geometry lives in an allocation of the shared MeshArena, with the sections stored back to back.
+class ChunkRenderMesh {
+public:
+  ChunkRenderMesh(MeshArena& arena, float creationTime)
+      : mArena(arena)
+      , mCreationTime(creationTime) {}
+
+  ~ChunkRenderMesh() { mArena.Free(mAllocation); }
+
+  ChunkRenderMesh(const ChunkRenderMesh&)            = delete;
+  ChunkRenderMesh& operator=(const ChunkRenderMesh&) = delete;
+
+  // Replaces the geometry of the sections in updatedSections with the ones in meshData, the other
+  // sections keep their current geometry. A partial update must use the level of detail the mesh
+  // already has.
+  void Update(const ChunkMesher::MeshData& meshData,
+              uint32_t                     updatedSections = ChunkMesher::AllSections) {
+    std::array<ChunkMesher::SectionRange, ChunkData::SectionCount> sections;
+    GLsizei vertexCount = 0;
+    GLsizei indexCount  = 0;
+    for (int i = 0; i < ChunkData::SectionCount; ++i) {
+      sections[i] = (updatedSections & (1u << i)) ? meshData.sections[i] : mSections[i];
+
+      sections[i].firstVertex = vertexCount;
+      sections[i].firstIndex  = indexCount;
+      vertexCount            += sections[i].vertexCount;
+      indexCount             += sections[i].indexCount;
+    }
+
+    const auto allocation = mArena.Allocate(vertexCount, indexCount);
+    if (updatedSections == ChunkMesher::AllSections) {
+      mArena.Upload(meshData.vertices,
+                    0,
+                    allocation.firstVertex,
+                    vertexCount,
+                    meshData.indices,
+                    0,
+                    allocation.firstIndex,
+                    indexCount);
+    } else {
+      for (int i = 0; i < ChunkData::SectionCount; ++i) {
+        const auto& section = sections[i];
+        if (section.indexCount == 0) continue;
+
+        if (updatedSections & (1u << i)) {
+          const auto& source = meshData.sections[i];
+          mArena.Upload(meshData.vertices,
+                        source.firstVertex,
+                        allocation.firstVertex + section.firstVertex,
+                        section.vertexCount,
+                        meshData.indices,
+                        source.firstIndex,
+                        allocation.firstIndex + section.firstIndex,
+                        section.indexCount);
+        } else {
+          const auto& source = mSections[i];
+          mArena.Copy(mAllocation.firstVertex + source.firstVertex,
+                      allocation.firstVertex + section.firstVertex,
+                      section.vertexCount,
+                      mAllocation.firstIndex + source.firstIndex,
+                      allocation.firstIndex + section.firstIndex,
+                      section.indexCount);
+        }
+      }
+    }
+
+    mArena.Free(mAllocation);
+    mAllocation = allocation;
+    mSections   = sections;
+    mLod        = meshData.lod;
+  }
+
+  const MeshArena::Allocation& GetAllocation() const { return mAllocation; }
+  const std::array<ChunkMesher::SectionRange, ChunkData::SectionCount>& GetSections() const {
+    return mSections;
+  }
+
+  std::size_t GetMemoryUsage() const {
+    return mAllocation.vertexCount * sizeof(MeshArena::Vertex) +
+           mAllocation.indexCount * sizeof(GLuint);
+  }
+
+  void SetOptimized() { mHasBeenOptimized = true; }
+  bool HasBeenOptimized() const { return mHasBeenOptimized; }
+
+  float GetCreationTime() const { return mCreationTime; }
+  int   GetLod() const { return mLod; }
+
+private:
+  static_assert(ChunkData::SectionCount <= 32, "Sections are selected with a 32 bit mask");
+
+  MeshArena&                                                     mArena;
+  MeshArena::Allocation                                          mAllocation;
+  std::array<ChunkMesher::SectionRange, ChunkData::SectionCount> mSections = {};
+
+  float mCreationTime     = {};
+  bool  mHasBeenOptimized = false;
+  int   mLod              = 0;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "chunk_renderer.hpp"
+
+#include <imgui.h>
+
+namespace dubu::block {
+
+namespace {
+// 56 MB to start with, the arena doubles when larger render distances need more
+constexpr GLsizei InitialArenaVertices = 4 * 1024 * 1024;
+constexpr GLsizei InitialArenaIndices  = InitialArenaVertices * 3 / 2;
+// Enough for the meshes in flight at the default limit, and a few frames worth of uploads
+constexpr GLsizeiptr StagingPoolSize = 32 * 1024 * 1024;
+}  // namespace
+
+ChunkRenderer::ChunkRenderer()
+    : mArena(InitialArenaVertices, InitialArenaIndices, StagingPoolSize) {
+  glGenVertexArrays(1, &mVao);
+  glGenBuffers(1, &mCommandBuffer);
+  glGenBuffers(1, &mInstanceBuffer);
+
+  glBindVertexArray(mVao);
+  glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ChunkInstance), (GLvoid*)0);
+  glVertexAttribDivisor(1, 1);
+  glEnableVertexAttribArray(0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ChunkRenderer::~ChunkRenderer() {
+  glDeleteVertexArrays(1, &mVao);
+  glDeleteBuffers(1, &mCommandBuffer);
+  glDeleteBuffers(1, &mInstanceBuffer);
+}
+
+void ChunkRenderer::BeginFrame() {
+  mCommands.clear();
+  mInstances.clear();
+}
+
+int ChunkRenderer::Add(const ChunkRenderMesh& renderMesh,
+                       ChunkCoords            coords,
+                       uint32_t               visibleSections) {
+  const auto& allocation   = renderMesh.GetAllocation();
+  const auto& sections     = renderMesh.GetSections();
+  const auto  baseInstance = static_cast<GLuint>(mInstances.size());
+  const auto  firstCommand = mCommands.size();
+
+  int triangles = 0;
+  for (int i = 0; i < ChunkData::SectionCount; ++i) {
+    const auto& section = sections[i];
+    if (!(visibleSections & (1u << i)) || section.indexCount == 0) continue;
+
+    mCommands.push_back({.count         = static_cast<GLuint>(section.indexCount),
+                         .instanceCount = 1,
+                         .firstIndex    = allocation.firstIndex + section.firstIndex,
+                         .baseVertex    = allocation.firstVertex + section.firstVertex,
+                         .baseInstance  = baseInstance});
+    triangles += section.indexCount / 3;
+  }
+
+  if (mCommands.size() == firstCommand) return 0;
+
+  mInstances.push_back({coords.x * ChunkData::ChunkSize.x,
+                        0.f,
+                        coords.z * ChunkData::ChunkSize.z,
+                        renderMesh.GetCreationTime()});
+  return triangles;
+}
+
+void ChunkRenderer::Draw(const FrameUniforms& frameUniforms) {
+  // Every mesh upload of the frame has been issued by now
+  mArena.FenceUploads();
+
+  if (mCommands.empty()) return;
+
+  mFrameUniforms.Update(frameUniforms);
+  mFrameUniforms.Bind(FrameUniformsBinding);
+
+  glBindVertexArray(mVao);
+
+  // The arena replaces its buffers when it grows
+  if (mBoundVertexBuffer != mArena.GetVertexBuffer()) {
+    mBoundVertexBuffer = mArena.GetVertexBuffer();
+    glBindBuffer(GL_ARRAY_BUFFER, mBoundVertexBuffer);
+    glVertexAttribIPointer(0,
+                           2,
+                           GL_UNSIGNED_INT,
+                           sizeof(MeshArena::Vertex),
+                           (GLvoid*)offsetof(MeshArena::Vertex, geometry));
+  }
+  if (mBoundIndexBuffer != mArena.GetIndexBuffer()) {
+    mBoundIndexBuffer = mArena.GetIndexBuffer();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mBoundIndexBuffer);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER,
+               mInstances.size() * sizeof(ChunkInstance),
+               mInstances.data(),
+               GL_STREAM_DRAW);
+
+  if (!GLAD_GL_VERSION_4_3) {
+    DrawCommandsSeparately();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommandBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               mCommands.size() * sizeof(DrawCommand),
+               mCommands.data(),
+               GL_STREAM_DRAW);
+  glMultiDrawElementsIndirect(
+      GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(mCommands.size()), 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  glBindVertexArray(0);
+}
+
+void ChunkRenderer::DrawCommandsSeparately() {
+  // Without base instances the instance attribute is pointed at the chunk of each draw instead,
+  // the commands of a chunk are consecutive so it only moves once per chunk
+  GLuint boundInstance = ~0u;
+  for (const auto& command : mCommands) {
+    if (command.baseInstance != boundInstance) {
+      boundInstance = command.baseInstance;
+      glVertexAttribPointer(1,
+                            4,
+                            GL_FLOAT,
+                            GL_FALSE,
+                            sizeof(ChunkInstance),
+                            (GLvoid*)(boundInstance * sizeof(ChunkInstance)));
+    }
+    glDrawElementsBaseVertex(GL_TRIANGLES,
+                             static_cast<GLsizei>(command.count),
+                             GL_UNSIGNED_INT,
+                             (GLvoid*)(command.firstIndex * sizeof(GLuint)),
+                             command.baseVertex);
+  }
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ChunkInstance), (GLvoid*)0);
+}
+
+void ChunkRenderer::Debug() {
+  ImGui::LabelText("Draw Commands", "%zu", mCommands.size());
+  ImGui::LabelText("Multi Draw Indirect", "%s", GLAD_GL_VERSION_4_3 ? "Yes" : "No");
+  ImGui::LabelText("Arena Memory",
+                   "%.2f / %.2f MB",
+                   mArena.GetMemoryUsage() / (1024.f * 1024.f),
+                   mArena.GetCapacity() / (1024.f * 1024.f));
+  ImGui::LabelText("Arena Free Ranges", "%zu", mArena.GetFreeRangeCount());
+
+  const auto& staging = mArena.GetStaging();
+  ImGui::LabelText("Upload Per Frame", "%.1f KB", mArena.GetLastFrameBytes() / 1024.f);
+  ImGui::LabelText("Staging In Use",
+                   "%.2f / %.2f MB",
+                   staging.GetBytesInUse() / (1024.f * 1024.f),
+                   staging.GetSize() / (1024.f * 1024.f));
+  ImGui::LabelText("Staging Fallbacks", "%zu", staging.GetFallbackCount());
+  ImGui::LabelText("Staging Persistent", "%s", staging.IsPersistent() ? "Yes" : "No");
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "game/chunk_data.hpp"
+#include "game/chunk_render_mesh.hpp"
+#include "gl/mesh_arena.hpp"
+#include "gl/uniform_buffer.hpp"
+
+namespace dubu::block {
+
+// Draws every visible chunk section with one glMultiDrawElementsIndirect call. All chunk geometry
+// is sub-allocated from the renderer's MeshArena, the per chunk origin and creation time are read
+// from an instanced vertex attribute selected through the base instance of each draw command.
+// Contexts older than OpenGL 4.3 issue the same commands as one draw call each.
+class ChunkRenderer {
+public:
+  // Mirrors the std140 FrameUniforms block in chunk.vert
+  struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 skyColor;
+    float     renderDistance;
+    glm::vec2 fogControl;
+    float     time;
+    float     padding = 0.f;
+  };
+  static_assert(offsetof(FrameUniforms, skyColor) == 128);
+  static_assert(offsetof(FrameUniforms, renderDistance) == 140);
+  static_assert(offsetof(FrameUniforms, fogControl) == 144);
+  static_assert(offsetof(FrameUniforms, time) == 152);
+  static_assert(sizeof(FrameUniforms) == 160);
+
+  static constexpr GLuint FrameUniformsBinding = 0;
+
+  ChunkRenderer();
+  ~ChunkRenderer();
+
+  ChunkRenderer(const ChunkRenderer&)            = delete;
+  ChunkRenderer& operator=(const ChunkRenderer&) = delete;
+
+  MeshArena& GetArena() { return mArena; }
+
+  void BeginFrame();
+  // Queues the sections of the chunk whose bit is set in visibleSections, returns the number of
+  // triangles queued
+  int  Add(const ChunkRenderMesh& renderMesh, ChunkCoords coords, uint32_t visibleSections);
+  void Draw(const FrameUniforms& frameUniforms);
+
+  void Debug();
+
+private:
+  // Issues mCommands one by one, with the VAO and the instance buffer bound
+  void DrawCommandsSeparately();
+
+  // Layout mandated by glMultiDrawElementsIndirect
+  struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+  };
+  // Origin of the chunk in xyz, creation time in w
+  using ChunkInstance = glm::vec4;
+
+  MeshArena                    mArena;
+  UniformBuffer<FrameUniforms> mFrameUniforms;
+
+  GLuint mVao;
+  GLuint mCommandBuffer;
+  GLuint mInstanceBuffer;
+  GLuint mBoundVertexBuffer = 0;
+  GLuint mBoundIndexBuffer  = 0;
+
+  std::vector<DrawCommand>   mCommands;
+  std::vector<ChunkInstance> mInstances;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
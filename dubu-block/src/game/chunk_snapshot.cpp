@@ -0,0 +1,65 @@
+#include "chunk_snapshot.hpp"
+
+#include <algorithm>
+
+namespace dubu::block {
+
+void ChunkSnapshot::Capture(const Neighbourhood& neighbourhood) {
+  const auto& center = *neighbourhood[4];
+
+  for (int s = 0; s < ChunkData::SectionCount; ++s) {
+    const auto& section = center.GetSection(s);
+    mUniformSections[s] = section.IsUniform() ? std::optional(section.GetUniformBlockType())
+                                              : std::nullopt;
+  }
+
+  for (int dz = -1; dz <= 1; ++dz) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      // Only the row or column of blocks touching the center chunk is copied from a neighbour
+      const glm::ivec3 from{dx < 0 ? ChunkData::ChunkSize.x - 1 : 0,
+                            0,
+                            dz < 0 ? ChunkData::ChunkSize.z - 1 : 0};
+      const glm::ivec3 to{dx > 0 ? 1 : ChunkData::ChunkSize.x,
+                          ChunkData::ChunkSize.y,
+                          dz > 0 ? 1 : ChunkData::ChunkSize.z};
+      const glm::ivec3 offset{dx * ChunkData::ChunkSize.x, 0, dz * ChunkData::ChunkSize.z};
+
+      if (const auto chunk = neighbourhood[(dx + 1) + (dz + 1) * 3]; chunk) {
+        CopyColumn(*chunk, from, to, offset);
+      } else {
+        for (int y = from.y; y < to.y; ++y) {
+          for (int z = from.z; z < to.z; ++z) {
+            for (int x = from.x; x < to.x; ++x) {
+              mBlocks[CoordsToIndex(glm::ivec3{x, y, z} + offset)] = BlockType::Empty;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void ChunkSnapshot::CopyColumn(const ChunkData& chunk,
+                               glm::ivec3       from,
+                               glm::ivec3       to,
+                               glm::ivec3       offset) {
+  for (int s = 0; s < ChunkData::SectionCount; ++s) {
+    const auto& section = chunk.GetSection(s);
+    const int   y0      = s * ChunkData::SectionHeight;
+
+    for (int y = y0; y < y0 + ChunkData::SectionHeight; ++y) {
+      for (int z = from.z; z < to.z; ++z) {
+        const auto row = mBlocks.begin() + CoordsToIndex(glm::ivec3{from.x, y, z} + offset);
+        if (section.IsUniform()) {
+          std::fill_n(row, to.x - from.x, section.GetUniformBlockType());
+          continue;
+        }
+        for (int x = from.x; x < to.x; ++x) {
+          row[x - from.x] = chunk.GetBlockTypeAtLocalCoords({x, y, z});
+        }
+      }
+    }
+  }
+}
+
+}  // namespace dubu::block
\ No newline at end of file
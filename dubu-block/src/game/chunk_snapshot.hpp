@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/block.hpp"
+#include "game/chunk_data.hpp"
+
+namespace dubu::block {
+
+// A flat copy of a chunk's blocks padded with a one block border taken from its eight neighbours,
+// so the mesher can sample every block it needs without map lookups, locks or bounds checks.
+class ChunkSnapshot {
+public:
+  static constexpr glm::ivec3 Size{
+      ChunkData::ChunkSize.x + 2, ChunkData::ChunkSize.y + 2, ChunkData::ChunkSize.z + 2};
+
+  // The chunk and its neighbours, indexed by (dx + 1) + (dz + 1) * 3. Missing neighbours are
+  // nullptr and treated as empty.
+  using Neighbourhood = std::array<const ChunkData*, 9>;
+
+  ChunkSnapshot()
+      : mBlocks(Size.x * Size.y * Size.z, BlockType::Empty) {}
+
+  void Capture(const Neighbourhood& neighbourhood);
+
+  // Valid for local coords within [-1, ChunkSize]
+  BlockType Get(glm::ivec3 coords) const { return mBlocks[CoordsToIndex(coords)]; }
+  bool      IsEmpty(glm::ivec3 coords) const { return Get(coords) == BlockType::Empty; }
+
+  std::optional<BlockType> GetUniformBlockType(int sectionIndex) const {
+    return mUniformSections[sectionIndex];
+  }
+
+  static inline std::size_t CoordsToIndex(glm::ivec3 coords) {
+    return (coords.x + 1) + (coords.z + 1) * Size.x + (coords.y + 1) * Size.x * Size.z;
+  }
+
+private:
+  void CopyColumn(const ChunkData& chunk, glm::ivec3 from, glm::ivec3 to, glm::ivec3 offset);
+
+  std::vector<BlockType>                                        mBlocks;
+  std::array<std::optional<BlockType>, ChunkData::SectionCount> mUniformSections;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
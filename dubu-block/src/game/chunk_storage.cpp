@@ -0,0 +1,92 @@
+#include "chunk_storage.hpp"
+
+#include <chrono>
+#include <string>
+
+#include <dubu_log/dubu_log.h>
+
+namespace dubu::block {
+
+ChunkStorage::ChunkStorage(std::filesystem::path root, int seed)
+    : mRoot(std::move(root))
+    , mSeed(seed) {}
+
+void ChunkStorage::SetSeed(int seed) {
+  mRegions.clear();
+  mSeed = seed;
+}
+
+std::unique_ptr<ChunkData> ChunkStorage::Load(const ChunkCoords& coords) {
+  RegionFile* region = FindRegion(coords, false);
+  if (!region) return nullptr;
+
+  const auto t0      = std::chrono::high_resolution_clock::now();
+  const auto payload = region->Read(coords);
+  if (payload.empty()) return nullptr;
+
+  auto chunk = std::make_unique<ChunkData>(coords);
+  if (!chunk->Deserialize(payload)) {
+    DUBU_LOG_ERROR("Saved chunk {}, {} is corrupt, it is generated again", coords.x, coords.z);
+    return nullptr;
+  }
+  const auto t1 = std::chrono::high_resolution_clock::now();
+
+  ++mStats.loads;
+  mStats.loadMilliseconds += std::chrono::duration<float, std::milli>(t1 - t0).count();
+  return chunk;
+}
+
+bool ChunkStorage::Save(const ChunkCoords& coords, std::span<const uint8_t> payload) {
+  RegionFile* region = FindRegion(coords, true);
+  if (!region) return false;
+
+  const auto t0 = std::chrono::high_resolution_clock::now();
+  if (!region->Write(coords, payload)) return false;
+  const auto t1 = std::chrono::high_resolution_clock::now();
+
+  ++mStats.saves;
+  mStats.saveMilliseconds += std::chrono::duration<float, std::milli>(t1 - t0).count();
+  mStats.savedBytes += payload.size();
+  return true;
+}
+
+void ChunkStorage::Clear() {
+  mRegions.clear();
+
+  std::error_code error;
+  std::filesystem::remove_all(GetDirectory(), error);
+  if (error) DUBU_LOG_ERROR("Failed to delete {}: {}", GetDirectory().string(), error.message());
+}
+
+RegionFile* ChunkStorage::FindRegion(const ChunkCoords& coords, bool create) {
+  const ChunkCoords regionCoords = RegionFile::ToRegionCoords(coords);
+  // Regions without a file stay as nullptr so the disk is only checked once for them
+  const auto [it, inserted] = mRegions.try_emplace(regionCoords);
+  if (it->second || (!inserted && !create)) return it->second.get();
+
+  const auto path = GetDirectory() / ("r." + std::to_string(regionCoords.x) + "." +
+                                      std::to_string(regionCoords.z) + ".region");
+  if (create) {
+    std::error_code error;
+    std::filesystem::create_directories(GetDirectory(), error);
+  } else if (!std::filesystem::exists(path)) {
+    return nullptr;
+  }
+
+  auto region = std::make_unique<RegionFile>(path);
+  if (region->IsOpen()) it->second = std::move(region);
+  return it->second.get();
+}
+
+ChunkStorage::Stats ChunkStorage::GetStats() const {
+  Stats stats = mStats;
+  for (const auto& [coords, region] : mRegions) {
+    if (!region) continue;
+    ++stats.regionCount;
+    stats.chunkCount += region->GetChunkCount();
+    stats.fileSize += region->GetFileSize();
+  }
+  return stats;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <unordered_map>
+
+#include "game/chunk_data.hpp"
+#include "game/region_file.hpp"
+
+namespace dubu::block {
+
+// Saves chunks to the region files of a world, one directory per seed so worlds of different
+// seeds never mix. Region files are opened the first time one of their chunks is used. Not
+// thread safe, ChunkIo calls it from its thread only.
+class ChunkStorage {
+public:
+  struct Stats {
+    std::size_t regionCount      = 0;
+    std::size_t chunkCount       = 0;
+    std::size_t fileSize         = 0;
+    std::size_t loads            = 0;
+    float       loadMilliseconds = 0.f;
+    std::size_t saves            = 0;
+    float       saveMilliseconds = 0.f;
+    std::size_t savedBytes       = 0;
+  };
+
+  ChunkStorage(std::filesystem::path root, int seed);
+
+  // Closes the region files of the current seed, chunks of the new one are read from then on
+  void SetSeed(int seed);
+  int  GetSeed() const { return mSeed; }
+
+  // nullptr if the chunk was never saved or can not be read
+  std::unique_ptr<ChunkData> Load(const ChunkCoords& coords);
+  // payload is a chunk written by ChunkData::Serialize
+  bool Save(const ChunkCoords& coords, std::span<const uint8_t> payload);
+
+  // Deletes every saved chunk of the current seed
+  void Clear();
+
+  Stats GetStats() const;
+
+private:
+  // nullptr if the region has no file and create is false
+  RegionFile* FindRegion(const ChunkCoords& coords, bool create);
+
+  std::filesystem::path GetDirectory() const { return mRoot / std::to_string(mSeed); }
+
+  std::filesystem::path mRoot;
+  int                   mSeed;
+
+  std::unordered_map<ChunkCoords, std::unique_ptr<RegionFile>> mRegions;
+
+  // Only the load and save counters, the rest is filled in by GetStats
+  Stats mStats;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
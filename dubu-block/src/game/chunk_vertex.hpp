@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dubu::block {
+
+// Packed chunk vertex, decoded in chunk.vert
+//   geometry: x:5 y:9 z:5 local block corner, face:3 direction index, occlusion:2
+//   material: blockType:8 color lookup, tile:8 atlas tile lookup
+struct ChunkVertex {
+  uint32_t geometry;
+  uint32_t material;
+};
+static_assert(sizeof(ChunkVertex) == 8);
+
+}  // namespace dubu::block
\ No newline at end of file
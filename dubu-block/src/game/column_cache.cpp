@@ -0,0 +1,97 @@
+#include "column_cache.hpp"
+
+#include <imgui.h>
+
+namespace dubu::block {
+
+ColumnCache::ColumnCache(const Seed& seed, std::size_t capacity)
+    : mSeed(seed)
+    , mSnapshot(std::make_shared<const Seed>(seed))
+    , mCapacity(capacity)
+    , mCurrentSeed(seed.GetSeed())
+    , mCurrentCurveVersion(seed.GetCurveVersion()) {}
+
+bool ColumnCache::Validate() {
+  std::scoped_lock lock(mMutex);
+  if (mCurrentSeed == mSeed.GetSeed() && mCurrentCurveVersion == mSeed.GetCurveVersion()) {
+    return true;
+  }
+
+  mCurrentSeed         = mSeed.GetSeed();
+  mCurrentCurveVersion = mSeed.GetCurveVersion();
+  mSnapshot            = std::make_shared<const Seed>(mSeed);
+  mEntries.clear();
+  mLookup.clear();
+  mMemoryUsage = 0;
+  return false;
+}
+
+std::shared_ptr<const ColumnCache::Columns> ColumnCache::GetColumns(const ChunkCoords& coords) {
+  Key                         key;
+  std::shared_ptr<const Seed> seed;
+  {
+    std::scoped_lock lock(mMutex);
+    key  = {mCurrentSeed, mCurrentCurveVersion, coords};
+    seed = mSnapshot;
+    if (auto it = mLookup.find(key); it != mLookup.end()) {
+      mEntries.splice(mEntries.begin(), mEntries, it->second);
+      ++mHits;
+      return it->second->columns;
+    }
+    ++mMisses;
+  }
+
+  // Sample outside the lock so the workers only wait on each other for the bookkeeping
+  auto columns = std::make_shared<Columns>();
+  seed->SampleColumns({coords.x * ChunkData::ChunkSize.x, coords.z * ChunkData::ChunkSize.z},
+                      {ChunkData::ChunkSize.x, ChunkData::ChunkSize.z},
+                      1.0f,
+                      *columns,
+                      Fields);
+  columns->sampleX = {};
+  columns->sampleZ = {};
+
+  std::scoped_lock lock(mMutex);
+  // Columns of an outdated seed are still handed out once, but never cached
+  if (key.seed != mCurrentSeed || key.curveVersion != mCurrentCurveVersion ||
+      mLookup.contains(key)) {
+    return columns;
+  }
+
+  mEntries.push_front({key, columns});
+  mLookup.emplace(key, mEntries.begin());
+  mMemoryUsage += GetEntryMemoryUsage(*columns);
+
+  while (mEntries.size() > mCapacity) {
+    mMemoryUsage -= GetEntryMemoryUsage(*mEntries.back().columns);
+    mLookup.erase(mEntries.back().key);
+    mEntries.pop_back();
+  }
+  return columns;
+}
+
+std::size_t ColumnCache::GetEntryMemoryUsage(const Columns& columns) {
+  // The list and lookup nodes are counted as an Entry and a Key plus three pointers each
+  return sizeof(Columns) + sizeof(Entry) + sizeof(Key) + 6 * sizeof(void*) +
+         (columns.continentalness.capacity() + columns.erosion.capacity() +
+          columns.peaksAndValleys.capacity()) *
+             sizeof(float);
+}
+
+void ColumnCache::Debug() {
+  std::scoped_lock lock(mMutex);
+
+  const std::size_t lookups = mHits + mMisses;
+  ImGui::LabelText("Column Cache",
+                   "%zu / %zu chunks, %.2f MB",
+                   mEntries.size(),
+                   mCapacity,
+                   mMemoryUsage / (1024.f * 1024.f));
+  ImGui::LabelText("Column Cache Hit Rate",
+                   "%.1f%% (%zu hits, %zu misses)",
+                   lookups == 0 ? 0.f : 100.f * mHits / lookups,
+                   mHits,
+                   mMisses);
+}
+
+}  // namespace dubu::block
\ No newline at end of file
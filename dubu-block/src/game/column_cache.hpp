@@ -0,0 +1,76 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "game/chunk_data.hpp"
+#include "generator/seed.hpp"
+
+namespace dubu::block {
+
+// Least recently used cache of the column noise of chunks, so chunks that are unloaded and loaded
+// again do not sample the seed again. Entries are keyed by the seed, its curve version and the
+// chunk coords. The workers sample a copy of the seed taken by Validate, never the one that is
+// edited, so GetColumns and GetSeed are safe to call from any thread.
+class ColumnCache {
+public:
+  using Columns = Seed::ColumnGrid;
+
+  // The fields the generation stages read
+  static constexpr uint32_t Fields = Seed::AllColumnFields;
+
+  ColumnCache(const Seed& seed, std::size_t capacity = 8192);
+
+  // Drops every entry and copies the seed again if the seed or its curves changed since the last
+  // call, call it from the thread that edits the seed. Returns false if the entries were dropped.
+  bool Validate();
+
+  std::shared_ptr<const Columns> GetColumns(const ChunkCoords& coords);
+
+  // The copy of the seed as of the last Validate
+  std::shared_ptr<const Seed> GetSeed() const {
+    std::scoped_lock lock(mMutex);
+    return mSnapshot;
+  }
+
+  void Debug();
+
+private:
+  struct Key {
+    int            seed;
+    uint32_t       curveVersion;
+    ChunkCoords    coords;
+    constexpr bool operator==(const Key& rhs) const = default;
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const noexcept {
+      return std::hash<ChunkCoords>{}(key.coords) ^
+             (static_cast<std::size_t>(key.seed) * 31 + key.curveVersion) * 0x9e3779b97f4a7c15ull;
+    }
+  };
+  struct Entry {
+    Key                            key;
+    std::shared_ptr<const Columns> columns;
+  };
+
+  static std::size_t GetEntryMemoryUsage(const Columns& columns);
+
+  const Seed&                 mSeed;
+  std::shared_ptr<const Seed> mSnapshot;
+  std::size_t                 mCapacity;
+
+  // Most recently used first
+  std::list<Entry>                                              mEntries;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> mLookup;
+
+  int                mCurrentSeed;
+  uint32_t           mCurrentCurveVersion;
+  std::size_t        mMemoryUsage = 0;
+  std::size_t        mHits        = 0;
+  std::size_t        mMisses      = 0;
+  mutable std::mutex mMutex;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
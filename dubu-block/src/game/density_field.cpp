@@ -0,0 +1,79 @@
+#include "density_field.hpp"
+
+#include <algorithm>
+
+namespace dubu::block {
+
+void DensityField::Sample(const Seed& seed, const Seed::ColumnGrid& columns, glm::ivec2 origin) {
+  mColumns = &columns;
+
+  // The density is negative wherever the column terms stay below zero with the detail noise at
+  // its maximum of one
+  float top = 0.f;
+  for (std::size_t i = 0; i < columns.continentalness.size(); ++i) {
+    const float surfaceHeight = Seed::SurfaceHeight(
+        columns.continentalness[i], columns.erosion[i], columns.peaksAndValleys[i]);
+    top = std::max(top, surfaceHeight + Seed::DensitySquash * Seed::Overhang(columns.erosion[i]));
+  }
+  mLevels = std::clamp(static_cast<int>(top) / CellSize.y + 2, 0, LatticeSize.y);
+
+  mDetail.resize(LatticeSize.x * LatticeSize.y * LatticeSize.z);
+  mCave.resize(mDetail.size());
+  for (int z = 0; z < LatticeSize.z; ++z) {
+    for (int x = 0; x < LatticeSize.x; ++x) {
+      for (int y = 0; y < mLevels; ++y) {
+        const glm::vec3 p{origin.x + x * CellSize.x, y * CellSize.y, origin.y + z * CellSize.z};
+        mDetail[LatticeIndex(x, y, z)] = seed.DetailNoise(p);
+        mCave[LatticeIndex(x, y, z)]   = seed.CaveNoise(p);
+      }
+    }
+  }
+}
+
+void DensityField::GetColumn(int x, int z, Column& density) const {
+  const std::size_t column        = mColumns->Index(x, z);
+  const float       erosion       = mColumns->erosion[column];
+  const float       overhang      = Seed::Overhang(erosion);
+  const float       surfaceHeight = Seed::SurfaceHeight(
+      mColumns->continentalness[column], erosion, mColumns->peaksAndValleys[column]);
+
+  // The four lattice columns around this one and their bilinear weights
+  const int   cellX = x / CellSize.x;
+  const int   cellZ = z / CellSize.z;
+  const float tx    = static_cast<float>(x % CellSize.x) / CellSize.x;
+  const float tz    = static_cast<float>(z % CellSize.z) / CellSize.z;
+
+  const std::array<std::size_t, 4> corners{LatticeIndex(cellX, 0, cellZ),
+                                           LatticeIndex(cellX + 1, 0, cellZ),
+                                           LatticeIndex(cellX, 0, cellZ + 1),
+                                           LatticeIndex(cellX + 1, 0, cellZ + 1)};
+  const std::array<float, 4>       weights{
+      (1 - tx) * (1 - tz), tx * (1 - tz), (1 - tx) * tz, tx * tz};
+
+  const auto Bilinear = [&](const std::vector<float>& lattice, int level) {
+    float value = 0.f;
+    for (int i = 0; i < 4; ++i) {
+      value += lattice[corners[i] + level] * weights[i];
+    }
+    return value;
+  };
+
+  int   y           = 0;
+  float detailBelow = mLevels > 0 ? Bilinear(mDetail, 0) : 0.f;
+  float caveBelow   = mLevels > 0 ? Bilinear(mCave, 0) : 0.f;
+  for (int level = 0; level + 1 < mLevels; ++level) {
+    const float detailAbove = Bilinear(mDetail, level + 1);
+    const float caveAbove   = Bilinear(mCave, level + 1);
+    for (int i = 0; i < CellSize.y; ++i, ++y) {
+      const float t      = static_cast<float>(i) / CellSize.y;
+      const float detail = detailBelow + (detailAbove - detailBelow) * t;
+      const float cave   = caveBelow + (caveAbove - caveBelow) * t;
+      density[y] = Seed::Density(static_cast<float>(y), surfaceHeight, overhang, detail, cave);
+    }
+    detailBelow = detailAbove;
+    caveBelow   = caveAbove;
+  }
+  std::fill(density.begin() + y, density.end(), -1.f);
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/chunk_data.hpp"
+#include "generator/seed.hpp"
+
+namespace dubu::block {
+
+// The density of every block of a chunk. The 3D noise is sampled on a lattice of CellSize cells
+// and trilinearly interpolated per block, the column terms are exact per block. Lattice levels
+// that no column can reach are not sampled at all.
+class DensityField {
+public:
+  static constexpr glm::ivec3 CellSize{4, 8, 4};
+  static constexpr glm::ivec3 LatticeSize{ChunkData::ChunkSize.x / CellSize.x + 1,
+                                          ChunkData::ChunkSize.y / CellSize.y + 1,
+                                          ChunkData::ChunkSize.z / CellSize.z + 1};
+
+  using Column = std::array<float, ChunkData::ChunkSize.y>;
+
+  // columns has to hold every field for the chunk columns starting at origin, and outlive the
+  // calls to GetColumn
+  void Sample(const Seed& seed, const Seed::ColumnGrid& columns, glm::ivec2 origin);
+
+  void GetColumn(int x, int z, Column& density) const;
+
+private:
+  static constexpr std::size_t LatticeIndex(int x, int y, int z) {
+    return y + LatticeSize.y * static_cast<std::size_t>(x + LatticeSize.x * z);
+  }
+
+  const Seed::ColumnGrid* mColumns = nullptr;
+  // Levels of the lattice sampled from the bottom, everything above is air
+  int                     mLevels  = 0;
+  std::vector<float>      mDetail;
+  std::vector<float>      mCave;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "downsampled_snapshot.hpp"
+
+namespace dubu::block {
+
+void DownsampledSnapshot::Capture(const ChunkSnapshot&     snapshot,
+                                  int                      lod,
+                                  const BlockDescriptions& blockDescriptions) {
+  mScale = 1 << lod;
+  mSize  = {ChunkData::ChunkSize.x / mScale,
+            ChunkData::ChunkSize.y / mScale,
+            ChunkData::ChunkSize.z / mScale};
+  mBlocks.assign(static_cast<std::size_t>(mSize.x + 2) * (mSize.y + 2) * (mSize.z + 2),
+                 BlockType::Empty);
+
+  // Blocks covered by a cell along one axis, border cells only reach the single block of padding
+  // the snapshot has
+  const auto BlockRange = [this](int cell, int size) -> glm::ivec2 {
+    if (cell < 0) return {-1, 0};
+    if (cell >= size) return {cell * mScale, cell * mScale + 1};
+    return {cell * mScale, (cell + 1) * mScale};
+  };
+
+  for (int cy = -1; cy <= mSize.y; ++cy) {
+    const glm::ivec2 ys = BlockRange(cy, mSize.y);
+    for (int cz = -1; cz <= mSize.z; ++cz) {
+      const glm::ivec2 zs = BlockRange(cz, mSize.z);
+      for (int cx = -1; cx <= mSize.x; ++cx) {
+        const glm::ivec2 xs = BlockRange(cx, mSize.x);
+
+        const bool border = cx < 0 || cz < 0 || cx >= mSize.x || cz >= mSize.z || cy < 0 ||
+                            cy >= mSize.y;
+        BlockType  cell   = BlockType::Empty;
+        if (border) {
+          // Solid only when it hides the whole face of the cell next to it
+          cell = snapshot.Get({xs.x, ys.x, zs.x});
+          for (int y = ys.x; y < ys.y && cell != BlockType::Empty; ++y) {
+            for (int z = zs.x; z < zs.y && cell != BlockType::Empty; ++z) {
+              for (int x = xs.x; x < xs.y; ++x) {
+                const auto blockType = snapshot.Get({x, y, z});
+                if (blockType == BlockType::Empty ||
+                    !blockDescriptions.GetBlockDescription(blockType).IsOpaque()) {
+                  cell = BlockType::Empty;
+                  break;
+                }
+              }
+            }
+          }
+        } else {
+          for (int y = ys.y - 1; y >= ys.x && cell == BlockType::Empty; --y) {
+            for (int z = zs.x; z < zs.y && cell == BlockType::Empty; ++z) {
+              for (int x = xs.x; x < xs.y; ++x) {
+                if (const auto blockType = snapshot.Get({x, y, z}); blockType != BlockType::Empty) {
+                  cell = blockType;
+                  break;
+                }
+              }
+            }
+          }
+        }
+        mBlocks[CoordsToIndex({cx, cy, cz})] = cell;
+      }
+    }
+  }
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/block.hpp"
+#include "game/chunk_snapshot.hpp"
+
+namespace dubu::block {
+
+// A chunk snapshot reduced to cells of 2^lod blocks along every axis, meshed in place of the full
+// resolution blocks for distant chunks. A cell holds the highest non-empty block inside it, so
+// thin surfaces are kept and the coarse terrain always covers the full resolution terrain. That
+// keeps the border between chunks of different detail free of holes. The one cell border around
+// the chunk only counts as solid where every block of the neighbour that touches it is opaque.
+class DownsampledSnapshot {
+public:
+  void Capture(const ChunkSnapshot&     snapshot,
+               int                      lod,
+               const BlockDescriptions& blockDescriptions);
+
+  // Valid for cell coords within [-1, GetSize()]
+  BlockType Get(glm::ivec3 coords) const { return mBlocks[CoordsToIndex(coords)]; }
+  bool      IsEmpty(glm::ivec3 coords) const { return Get(coords) == BlockType::Empty; }
+
+  // Size of the chunk in cells, without the border
+  glm::ivec3 GetSize() const { return mSize; }
+  int        GetScale() const { return mScale; }
+
+private:
+  std::size_t CoordsToIndex(glm::ivec3 coords) const {
+    return (coords.x + 1) + (coords.z + 1) * (mSize.x + 2) +
+           (coords.y + 1) * (mSize.x + 2) * (mSize.z + 2);
+  }
+
+  std::vector<BlockType> mBlocks;
+  glm::ivec3             mSize  = {};
+  int                    mScale = 1;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
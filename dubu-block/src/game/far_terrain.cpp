@@ -0,0 +1,299 @@
+#include "far_terrain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+#include <dubu_log/dubu_log.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <imgui.h>
+
+#include "gl/shader.hpp"
+#include "io/io.hpp"
+
+namespace dubu::block {
+
+namespace {
+constexpr std::array<uint8_t, 4> StoneColor{128, 128, 128, 255};
+constexpr std::array<uint8_t, 4> WaterColor{54, 98, 196, 255};
+
+float DistanceToTile(ChunkCoords tileCoords, glm::vec2 camera) {
+  const glm::vec2 tileMin = glm::vec2(tileCoords.x, tileCoords.z) * float(FarTerrain::TileSize);
+  const glm::vec2 closest = glm::clamp(camera, tileMin, tileMin + float(FarTerrain::TileSize));
+  return glm::length(closest - camera);
+}
+
+float FarthestDistanceInTile(ChunkCoords tileCoords, glm::vec2 camera) {
+  const glm::vec2 tileMin = glm::vec2(tileCoords.x, tileCoords.z) * float(FarTerrain::TileSize);
+  const glm::vec2 tileMax = tileMin + float(FarTerrain::TileSize);
+  return glm::length(glm::max(glm::abs(tileMin - camera), glm::abs(tileMax - camera)));
+}
+}  // namespace
+
+FarTerrain::FarTerrain(const Seed& seed)
+    : mSeed(seed)
+    , mSeedSnapshot(std::make_shared<const Seed>(seed))
+    , mSnapshotSeed(seed.GetSeed())
+    , mSnapshotCurveVersion(seed.GetCurveVersion()) {
+  VertexShader   vertexShader(ReadFile("assets/shaders/far_terrain.vert"));
+  FragmentShader fragmentShader(ReadFile("assets/shaders/far_terrain.frag"));
+  mProgram.Link(vertexShader, fragmentShader);
+  if (const auto err = mProgram.GetError()) {
+    DUBU_LOG_ERROR("shader program error: {}", *err);
+  }
+}
+
+FarTerrain::~FarTerrain() {
+  for (const auto& [coords, tile] : mTiles) {
+    DeleteTile(tile);
+  }
+  for (const auto& [spacing, grid] : mGrids) {
+    glDeleteBuffers(1, &grid.indexBuffer);
+  }
+}
+
+void FarTerrain::Update(const glm::vec3& cameraPosition, float innerRadius) {
+  mInnerRadius = innerRadius;
+
+  if (mSeed.GetSeed() != mSnapshotSeed || mSeed.GetCurveVersion() != mSnapshotCurveVersion) {
+    mSnapshotSeed         = mSeed.GetSeed();
+    mSnapshotCurveVersion = mSeed.GetCurveVersion();
+    mSeedSnapshot         = std::make_shared<const Seed>(mSeed);
+
+    for (const auto& [coords, tile] : mTiles) {
+      DeleteTile(tile);
+    }
+    mTiles.clear();
+    mPendingTiles.clear();
+  }
+
+  std::vector<GeneratedTile> generatedTiles;
+  {
+    std::scoped_lock lock(mGeneratedTilesMutex);
+    std::swap(generatedTiles, mGeneratedTiles);
+  }
+  for (auto& generated : generatedTiles) {
+    if (generated.seed != mSnapshotSeed || generated.curveVersion != mSnapshotCurveVersion)
+      continue;
+    mPendingTiles.erase(generated.coords);
+    UploadTile(mTiles[generated.coords], generated);
+  }
+
+  if (!mEnabled) return;
+
+  // Request every tile that reaches into the ring between the chunks and the horizon, tiles with
+  // a different spacing keep being drawn until their replacement is done
+  const glm::vec2  camera{cameraPosition.x, cameraPosition.z};
+  const glm::ivec2 minTile(glm::floor((camera - float(mHorizon)) / float(TileSize)));
+  const glm::ivec2 maxTile(glm::floor((camera + float(mHorizon)) / float(TileSize)));
+
+  std::unordered_set<ChunkCoords> wantedTiles;
+  for (int z = minTile.y; z <= maxTile.y; ++z) {
+    for (int x = minTile.x; x <= maxTile.x; ++x) {
+      const ChunkCoords coords{x, z};
+      if (DistanceToTile(coords, camera) > mHorizon) continue;
+      if (FarthestDistanceInTile(coords, camera) < innerRadius) continue;
+      wantedTiles.insert(coords);
+
+      const int spacing = SelectSpacing(coords, cameraPosition);
+      if (auto it = mTiles.find(coords); it != mTiles.end() && it->second.spacing == spacing)
+        continue;
+      if (auto it = mPendingTiles.find(coords); it != mPendingTiles.end() && it->second == spacing)
+        continue;
+
+      mPendingTiles[coords] = spacing;
+      mThreadPool.Enqueue([this, seed = mSeedSnapshot, coords, spacing] {
+        auto generated = GenerateTile(*seed, coords, spacing);
+
+        std::scoped_lock lock(mGeneratedTilesMutex);
+        mGeneratedTiles.push_back(std::move(generated));
+      });
+    }
+  }
+
+  std::erase_if(mTiles, [&wantedTiles](const auto& p) {
+    if (wantedTiles.contains(p.first)) return false;
+    DeleteTile(p.second);
+    return true;
+  });
+}
+
+void FarTerrain::Draw(const glm::mat4& viewProjection,
+                      const glm::vec3& cameraPosition,
+                      const glm::vec3& skyColor,
+                      const glm::vec2& fogControl) const {
+  if (!mEnabled || mTiles.empty()) return;
+
+  mProgram.Use();
+  glUniformMatrix4fv(mProgram.GetUniformLocation("VIEW_PROJECTION"),
+                     1,
+                     GL_FALSE,
+                     glm::value_ptr(viewProjection));
+  glUniform3fv(mProgram.GetUniformLocation("CAMERA_POSITION"), 1, glm::value_ptr(cameraPosition));
+  glUniform3fv(mProgram.GetUniformLocation("SKYCOLOR"), 1, glm::value_ptr(skyColor));
+  glUniform2fv(mProgram.GetUniformLocation("FOG_CONTROL"), 1, glm::value_ptr(fogControl));
+  glUniform1f(mProgram.GetUniformLocation("HORIZON"), static_cast<float>(mHorizon));
+  glUniform1f(mProgram.GetUniformLocation("INNER_RADIUS"), mInnerRadius);
+
+  // Skirts face both ways
+  glDisable(GL_CULL_FACE);
+  for (const auto& [coords, tile] : mTiles) {
+    glBindVertexArray(tile.vao);
+    glDrawElements(GL_TRIANGLES, mGrids.at(tile.spacing).indexCount, GL_UNSIGNED_INT, nullptr);
+  }
+  glBindVertexArray(0);
+  glEnable(GL_CULL_FACE);
+}
+
+void FarTerrain::Debug() {
+  ImGui::Checkbox("Far Terrain", &mEnabled);
+  ImGui::SliderInt("Horizon", &mHorizon, 1024, 16384);
+
+  std::size_t memoryUsage = 0;
+  for (const auto& [coords, tile] : mTiles) {
+    memoryUsage += tile.memoryUsage;
+  }
+  ImGui::LabelText("Far Terrain Tiles", "%zu (%zu pending)", mTiles.size(), mPendingTiles.size());
+  ImGui::LabelText("Far Terrain Memory", "%.2f MB", memoryUsage / (1024.f * 1024.f));
+}
+
+int FarTerrain::SelectSpacing(ChunkCoords tileCoords, const glm::vec3& cameraPosition) const {
+  const float distance = DistanceToTile(tileCoords, {cameraPosition.x, cameraPosition.z});
+  if (distance < 1024) return 8;
+  if (distance < 2048) return 16;
+  return 32;
+}
+
+FarTerrain::GeneratedTile FarTerrain::GenerateTile(const Seed& seed,
+                                                   ChunkCoords tileCoords,
+                                                   int         spacing) {
+  const int       cells  = TileSize / spacing;
+  const glm::vec2 origin = glm::vec2(tileCoords.x, tileCoords.z) * float(TileSize);
+
+  // Heights with one extra sample around the tile for the normals along the edges
+  const int        samples = cells + 3;
+  Seed::ColumnGrid columns;
+  seed.SampleColumns(origin - float(spacing),
+                     {samples, samples},
+                     float(spacing),
+                     columns);
+  const auto HeightAt = [&](int i, int j) {
+    const std::size_t index = columns.Index(i + 1, j + 1);
+    return Seed::SurfaceHeight(
+        columns.continentalness[index], columns.erosion[index], columns.peaksAndValleys[index]);
+  };
+  // The top of the highest block, water covers everything below sea level
+  const auto SurfaceAt = [&](int i, int j) {
+    return std::max(HeightAt(i, j), static_cast<float>(Seed::SeaLevel)) + 1.0f;
+  };
+
+  GeneratedTile tile{tileCoords, spacing, seed.GetSeed(), seed.GetCurveVersion(), {}};
+  tile.vertices.reserve((cells + 1) * (cells + 1) + 4 * (cells + 1));
+  for (int j = 0; j <= cells; ++j) {
+    for (int i = 0; i <= cells; ++i) {
+      const glm::vec3 normal = glm::normalize(glm::vec3{SurfaceAt(i - 1, j) - SurfaceAt(i + 1, j),
+                                                        2.0f * spacing,
+                                                        SurfaceAt(i, j - 1) - SurfaceAt(i, j + 1)});
+      tile.vertices.push_back(
+          {{origin.x + i * spacing, SurfaceAt(i, j), origin.y + j * spacing},
+           {static_cast<int8_t>(normal.x * 127),
+            static_cast<int8_t>(normal.y * 127),
+            static_cast<int8_t>(normal.z * 127),
+            0},
+           HeightAt(i, j) < Seed::SeaLevel ? WaterColor : StoneColor});
+    }
+  }
+
+  // Skirts along the edges in the order Grid expects them: j = 0, j = cells, i = 0, i = cells
+  const float skirtDepth = 4.0f * spacing;
+  for (int edge = 0; edge < 4; ++edge) {
+    for (int k = 0; k <= cells; ++k) {
+      const int i = edge < 2 ? k : (edge == 2 ? 0 : cells);
+      const int j = edge < 2 ? (edge == 0 ? 0 : cells) : k;
+
+      Vertex skirt = tile.vertices[i + j * (cells + 1)];
+      skirt.position.y -= skirtDepth;
+      tile.vertices.push_back(skirt);
+    }
+  }
+  return tile;
+}
+
+void FarTerrain::UploadTile(Tile& tile, const GeneratedTile& generated) {
+  if (tile.vao == 0) {
+    glGenVertexArrays(1, &tile.vao);
+    glGenBuffers(1, &tile.vertexBuffer);
+
+    glBindVertexArray(tile.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, tile.vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(
+        0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(
+        1, 4, GL_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(
+        2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, color));
+  }
+
+  tile.spacing     = generated.spacing;
+  tile.memoryUsage = generated.vertices.size() * sizeof(Vertex);
+
+  glBindVertexArray(tile.vao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GetGrid(tile.spacing).indexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, tile.vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, tile.memoryUsage, generated.vertices.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void FarTerrain::DeleteTile(const Tile& tile) {
+  glDeleteVertexArrays(1, &tile.vao);
+  glDeleteBuffers(1, &tile.vertexBuffer);
+}
+
+const FarTerrain::Grid& FarTerrain::GetGrid(int spacing) {
+  if (auto it = mGrids.find(spacing); it != mGrids.end()) return it->second;
+
+  const int  cells     = TileSize / spacing;
+  const auto GridIndex = [cells](int i, int j) { return GLuint(i + j * (cells + 1)); };
+
+  std::vector<GLuint> indices;
+  for (int j = 0; j < cells; ++j) {
+    for (int i = 0; i < cells; ++i) {
+      indices.insert(indices.end(),
+                     {GridIndex(i, j),
+                      GridIndex(i + 1, j),
+                      GridIndex(i + 1, j + 1),
+                      GridIndex(i, j),
+                      GridIndex(i + 1, j + 1),
+                      GridIndex(i, j + 1)});
+    }
+  }
+
+  const GLuint skirtBase = GridIndex(0, cells + 1);
+  for (int edge = 0; edge < 4; ++edge) {
+    const auto EdgeIndex = [&](int k) {
+      return edge < 2 ? GridIndex(k, edge == 0 ? 0 : cells) : GridIndex(edge == 2 ? 0 : cells, k);
+    };
+    for (int k = 0; k < cells; ++k) {
+      const GLuint skirt = skirtBase + edge * (cells + 1) + k;
+      indices.insert(indices.end(),
+                     {EdgeIndex(k), EdgeIndex(k + 1), skirt + 1, EdgeIndex(k), skirt + 1, skirt});
+    }
+  }
+
+  Grid grid{.indexCount = static_cast<GLsizei>(indices.size())};
+  // Uploaded through the copy target, binding the element array would change the bound VAO
+  glGenBuffers(1, &grid.indexBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, grid.indexBuffer);
+  glBufferData(GL_COPY_WRITE_BUFFER,
+               indices.size() * sizeof(GLuint),
+               indices.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  return mGrids.emplace(spacing, grid).first->second;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
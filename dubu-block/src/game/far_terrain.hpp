@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "game/chunk_data.hpp"
+#include "generator/seed.hpp"
+#include "gl/shader_program.hpp"
+#include "util/thread_pool.hpp"
+
+namespace dubu::block {
+
+// Terrain beyond the voxel render distance, drawn as heightmap tiles sampled straight from the
+// Seed. Every tile is a grid of TileSize blocks whose spacing grows with the distance to the
+// camera, with skirts hanging from its edges to hide the cracks between tiles of different
+// spacing. Tiles are drawn before the chunks with their own far plane, and fragments within the
+// voxel render distance are discarded so the chunks show through.
+class FarTerrain {
+public:
+  static constexpr int TileSize = 512;
+
+  FarTerrain(const Seed& seed);
+  ~FarTerrain();
+
+  FarTerrain(const FarTerrain&)            = delete;
+  FarTerrain& operator=(const FarTerrain&) = delete;
+
+  // Requests the tiles around the camera and uploads the ones the workers have finished
+  void Update(const glm::vec3& cameraPosition, float innerRadius);
+
+  // viewProjection needs a far plane of at least GetHorizon()
+  void Draw(const glm::mat4& viewProjection,
+            const glm::vec3& cameraPosition,
+            const glm::vec3& skyColor,
+            const glm::vec2& fogControl) const;
+
+  bool  IsEnabled() const { return mEnabled; }
+  float GetHorizon() const { return static_cast<float>(mHorizon); }
+
+  void Debug();
+
+private:
+  struct Vertex {
+    glm::vec3               position;
+    std::array<int8_t, 4>  normal;
+    std::array<uint8_t, 4> color;
+  };
+
+  // Vertices of a tile, grid first and then the skirt below each of the four edges, with the seed
+  // and curve version they were sampled from
+  struct GeneratedTile {
+    ChunkCoords         coords;
+    int                 spacing;
+    int                 seed;
+    uint32_t            curveVersion;
+    std::vector<Vertex> vertices;
+  };
+
+  // Every tile has its own vertex array, with the index buffer of the grid of its spacing
+  struct Tile {
+    int         spacing      = 0;
+    GLuint      vao          = 0;
+    GLuint      vertexBuffer = 0;
+    std::size_t memoryUsage  = 0;
+  };
+
+  struct Grid {
+    GLuint  indexBuffer = 0;
+    GLsizei indexCount  = 0;
+  };
+
+  int SelectSpacing(ChunkCoords tileCoords, const glm::vec3& cameraPosition) const;
+
+  static GeneratedTile GenerateTile(const Seed& seed, ChunkCoords tileCoords, int spacing);
+  const Grid&          GetGrid(int spacing);
+  void                 UploadTile(Tile& tile, const GeneratedTile& generated);
+  static void          DeleteTile(const Tile& tile);
+
+  // The workers sample a copy of the seed, taken again whenever the seed or its curves change.
+  // The tiles are dropped then, and tiles still being generated from the old copy are discarded.
+  const Seed&                 mSeed;
+  std::shared_ptr<const Seed> mSeedSnapshot;
+  int                         mSnapshotSeed;
+  uint32_t                    mSnapshotCurveVersion;
+
+  ShaderProgram mProgram;
+
+  // Tiles are keyed by their coords in tiles, grids by their spacing in blocks
+  std::unordered_map<ChunkCoords, Tile> mTiles;
+  std::unordered_map<ChunkCoords, int>  mPendingTiles;
+  std::map<int, Grid>                   mGrids;
+  float                                 mInnerRadius = 0.f;
+
+  std::vector<GeneratedTile> mGeneratedTiles;
+  std::mutex                 mGeneratedTilesMutex;
+
+  bool mEnabled = true;
+  int  mHorizon = 4096;
+
+  // Declared last so the workers are joined before anything they touch is destroyed
+  ThreadPool mThreadPool{2};
+};
+
+}  // namespace dubu::block
\ No newline at end of file
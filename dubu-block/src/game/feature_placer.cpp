@@ -0,0 +1,163 @@
+#include "feature_placer.hpp"
+
+#include <cstdlib>
+
+#include "generator/seed.hpp"
+
+namespace dubu::block {
+
+namespace {
+// One in this many dry columns grows a tree
+constexpr uint32_t TreeChance = 100;
+
+uint32_t HashColumn(int seed, int x, int z) {
+  uint32_t hash = static_cast<uint32_t>(seed) * 0x9e3779b1u;
+  hash ^= static_cast<uint32_t>(x) * 0x85ebca6bu;
+  hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;
+  hash ^= static_cast<uint32_t>(z) * 0x27d4eb2fu;
+  hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;
+  return hash ^ (hash >> 13);
+}
+
+// Floor division, so blocks left of or behind the chunk land in the previous chunk
+int ChunkOffset(int coord, int size) {
+  return coord < 0 ? (coord - size + 1) / size : coord / size;
+}
+}  // namespace
+
+void FeaturePlacer::PlaceTrees(const HeightFunction& heightAt) {
+  const auto& size = ChunkData::ChunkSize;
+  for (int z = 0; z < size.z; ++z) {
+    for (int x = 0; x < size.x; ++x) {
+      const int height = heightAt(x, z);
+      if (height < Seed::SeaLevel) continue;
+
+      const glm::ivec3 worldCoords = mChunk.LocalToWorldCoords({x, height, z});
+      const uint32_t   hash        = HashColumn(mSeed, worldCoords.x, worldCoords.z);
+      if (hash % TreeChance != 0) continue;
+
+      // Trees only grow on flat ground, which can reach into the neighbouring chunks
+      bool flat = true;
+      for (int dz = -2; dz <= 2 && flat; ++dz) {
+        for (int dx = -2; dx <= 2 && flat; ++dx) {
+          flat = std::abs(heightAt(x + dx, z + dz) - height) <= 1;
+        }
+      }
+      if (!flat) continue;
+
+      const int trunkHeight = 4 + static_cast<int>((hash >> 8) % 3);
+      if (height + trunkHeight + 2 >= size.y) continue;
+
+      PlaceTree({x, height + 1, z}, trunkHeight, hash);
+    }
+  }
+}
+
+void FeaturePlacer::PlaceTree(glm::ivec3 base, int trunkHeight, uint32_t hash) {
+  const int top = base.y + trunkHeight - 1;
+  for (int y = top - 2; y <= top + 1; ++y) {
+    const int radius = y < top ? 2 : 1;
+    for (int dz = -radius; dz <= radius; ++dz) {
+      for (int dx = -radius; dx <= radius; ++dx) {
+        if (std::abs(dx) == radius && std::abs(dz) == radius) {
+          // The top layer is a plus, the corners of the layers below are left out at random
+          const int bit = 12 + (y - top + 2) * 4 + (dx > 0) * 2 + (dz > 0);
+          if (y == top + 1 || (hash >> bit) & 1) continue;
+        }
+        SetBlock({base.x + dx, y, base.z + dz}, BlockType::OakLeaves, true);
+      }
+    }
+  }
+  for (int y = base.y; y <= top; ++y) {
+    SetBlock({base.x, y, base.z}, BlockType::OakLog, false);
+  }
+}
+
+void FeaturePlacer::SetBlock(glm::ivec3 coords, BlockType blockType, bool onlyAir) {
+  if (coords.y < 0 || coords.y >= ChunkData::ChunkSize.y) return;
+
+  const int dx = ChunkOffset(coords.x, ChunkData::ChunkSize.x);
+  const int dz = ChunkOffset(coords.z, ChunkData::ChunkSize.z);
+  if (dx != 0 || dz != 0) {
+    const auto& chunkCoords = mChunk.GetChunkCoords();
+    mSpills[{chunkCoords.x + dx, chunkCoords.z + dz}].push_back(
+        {{coords.x - dx * ChunkData::ChunkSize.x, coords.y, coords.z - dz * ChunkData::ChunkSize.z},
+         blockType});
+    return;
+  }
+
+  if (onlyAir && mChunk.GetBlockTypeAtLocalCoords(coords) != BlockType::Empty) return;
+  mChunk.SetBlockTypeAtLocalCoords(coords, blockType);
+}
+
+void FeaturePlacer::ApplySpills(ChunkData& chunk, const std::vector<SpilledBlock>& blocks) {
+  for (const auto& [coords, blockType] : blocks) {
+    if (chunk.GetBlockTypeAtLocalCoords(coords) == BlockType::Empty) {
+      chunk.SetBlockTypeAtLocalCoords(coords, blockType);
+    }
+  }
+}
+
+void SpillBuffers::Store(const ChunkCoords& source, FeaturePlacer::Spills&& spills) {
+  std::scoped_lock lock(mMutex);
+  // Targets the features no longer reach into must not keep the earlier spills
+  EraseLocked(source);
+  for (auto& [target, blocks] : spills) {
+    mBuffers[target][source] = std::move(blocks);
+  }
+}
+
+std::vector<FeaturePlacer::SpilledBlock> SpillBuffers::Collect(const ChunkCoords& target) const {
+  std::vector<FeaturePlacer::SpilledBlock> blocks;
+
+  std::scoped_lock lock(mMutex);
+  auto             sources = mBuffers.find(target);
+  if (sources == mBuffers.end()) return blocks;
+
+  // Features only reach into the chunks right next to them
+  for (int dz = -1; dz <= 1; ++dz) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      if (auto it = sources->second.find({target.x + dx, target.z + dz});
+          it != sources->second.end()) {
+        blocks.insert(blocks.end(), it->second.begin(), it->second.end());
+      }
+    }
+  }
+  return blocks;
+}
+
+void SpillBuffers::Erase(const ChunkCoords& source) {
+  std::scoped_lock lock(mMutex);
+  EraseLocked(source);
+}
+
+void SpillBuffers::EraseLocked(const ChunkCoords& source) {
+  for (int dz = -1; dz <= 1; ++dz) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      auto sources = mBuffers.find({source.x + dx, source.z + dz});
+      if (sources == mBuffers.end()) continue;
+      sources->second.erase(source);
+      if (sources->second.empty()) mBuffers.erase(sources);
+    }
+  }
+}
+
+std::size_t SpillBuffers::GetChunkCount() const {
+  std::scoped_lock lock(mMutex);
+  return mBuffers.size();
+}
+
+std::size_t SpillBuffers::GetMemoryUsage() const {
+  std::scoped_lock lock(mMutex);
+  std::size_t memoryUsage = 0;
+  for (const auto& [target, sources] : mBuffers) {
+    memoryUsage += sizeof(target) + sizeof(sources);
+    for (const auto& [source, blocks] : sources) {
+      memoryUsage += sizeof(source) + sizeof(blocks) +
+                     blocks.capacity() * sizeof(FeaturePlacer::SpilledBlock);
+    }
+  }
+  return memoryUsage;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
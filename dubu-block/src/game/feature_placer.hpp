@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game/chunk_data.hpp"
+
+namespace dubu::block {
+
+// Places the features of one chunk, which only depend on the seed and the ground around them.
+// Blocks that land outside of the chunk are collected per neighbouring chunk instead, so they can
+// be applied once that chunk has been generated.
+class FeaturePlacer {
+public:
+  // Spilled blocks are in the local coords of the chunk they land in, and only fill air
+  struct SpilledBlock {
+    glm::ivec3 coords;
+    BlockType  blockType;
+  };
+  using Spills = std::unordered_map<ChunkCoords, std::vector<SpilledBlock>>;
+
+  // Highest solid block of a column in local coords, up to a chunk outside of this one
+  using HeightFunction = std::function<int(int x, int z)>;
+
+  FeaturePlacer(ChunkData& chunk, int seed)
+      : mChunk(chunk)
+      , mSeed(seed) {}
+
+  void PlaceTrees(const HeightFunction& heightAt);
+
+  Spills& GetSpills() { return mSpills; }
+
+  static void ApplySpills(ChunkData& chunk, const std::vector<SpilledBlock>& blocks);
+
+private:
+  void PlaceTree(glm::ivec3 base, int trunkHeight, uint32_t hash);
+  // Writes into the chunk or spills into the neighbour the coords land in
+  void SetBlock(glm::ivec3 coords, BlockType blockType, bool onlyAir);
+
+  ChunkData& mChunk;
+  int        mSeed;
+  Spills     mSpills;
+};
+
+// The blocks spilled into chunks by the features of their neighbours. They are kept per target and
+// source chunk, so a chunk that is generated again gets the same spills without generating its
+// neighbours again, and placing the features of a source again replaces its earlier spills.
+// The spills of a source have to be kept for as long as the source is, whether their target is
+// or not. A source that has placed its features never places them again, so a target forgotten
+// and generated again on its own can only get them from here.
+class SpillBuffers {
+public:
+  void Store(const ChunkCoords& source, FeaturePlacer::Spills&& spills);
+
+  // Every block spilled into target, in the same order every time
+  std::vector<FeaturePlacer::SpilledBlock> Collect(const ChunkCoords& target) const;
+
+  // Forgets the spills of source, once source is forgotten itself
+  void Erase(const ChunkCoords& source);
+
+  std::size_t GetChunkCount() const;
+  std::size_t GetMemoryUsage() const;
+
+private:
+  using Sources = std::unordered_map<ChunkCoords, std::vector<FeaturePlacer::SpilledBlock>>;
+
+  void EraseLocked(const ChunkCoords& source);
+
+  std::unordered_map<ChunkCoords, Sources> mBuffers;
+  mutable std::mutex                       mMutex;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,387 @@
+#include "generation_pipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include <imgui.h>
+
+#include "generator/seed.hpp"
+
+namespace dubu::block {
+
+namespace {
+// Dirt below the top block of every column
+constexpr int SoilDepth = 3;
+constexpr std::size_t HeightmapIndex(int x, int z) {
+  return x + z * static_cast<std::size_t>(ChunkData::ChunkSize.x);
+}
+}  // namespace
+
+GenerationPipeline::GenerationPipeline(ColumnCache& columnCache, ThreadPool& threadPool)
+    : mColumnCache(columnCache)
+    , mThreadPool(threadPool) {}
+
+void GenerationPipeline::Request(const ChunkCoords& coords) {
+  auto& slot = mSlots[coords];
+  if (!slot) slot = std::make_unique<Slot>(coords);
+
+  // Chunks that were handed out before are generated again, their spills are still around
+  if (!slot->chunk) {
+    slot->chunk = std::make_unique<ChunkData>(coords);
+    slot->stage = Stage::Shape;
+  }
+
+  // A discarded chunk may be from an earlier seed, it is generated from scratch once no stage
+  // touches it anymore
+  if (slot->discarded) {
+    slot->discarded = false;
+    slot->restart   = true;
+  }
+  slot->target = Stage::Done;
+  if (!slot->requested) {
+    slot->requested = true;
+    ++mPendingCount;
+  }
+}
+
+void GenerationPipeline::Update(std::vector<std::unique_ptr<ChunkData>>& finishedChunks) {
+  ReceiveCompletions();
+
+  std::vector<ChunkCoords> missingNeighbours;
+  for (auto it = mSlots.begin(); it != mSlots.end();) {
+    Slot&      slot = *it->second;
+    const bool idle = !slot.running && slot.readers == 0;
+    if (!idle) {
+      ++it;
+      continue;
+    }
+
+    if (slot.discarded) {
+      if (slot.requested) --mPendingCount;
+      mSpillBuffers.Erase(it->first);
+      it = mSlots.erase(it);
+      continue;
+    }
+
+    if (slot.restart) {
+      // Starts over with a fresh slot, only the request carries over
+      mSpillBuffers.Erase(it->first);
+      auto fresh       = std::make_unique<Slot>(it->first);
+      fresh->requested = slot.requested;
+      fresh->target    = slot.target;
+      it->second       = std::move(fresh);
+      continue;
+    }
+
+    if (slot.stage < slot.target) {
+      TryDispatch(slot, missingNeighbours);
+    } else if (slot.stage == Stage::Done && slot.requested) {
+      // All neighbours have placed their features by now, so none of them reads the chunk again
+      slot.requested = false;
+      --mPendingCount;
+      finishedChunks.push_back(std::move(slot.chunk));
+    }
+    ++it;
+  }
+
+  // Neighbours are only generated as far as the stages that read them need, TryDispatch raises
+  // their target the next time around
+  for (const auto& coords : missingNeighbours) {
+    mSlots.try_emplace(coords, std::make_unique<Slot>(coords));
+  }
+}
+
+bool GenerationPipeline::TryDispatch(Slot& slot, std::vector<ChunkCoords>& missingNeighbours) {
+  static_assert(std::ranges::all_of(Stages, [](const auto& s) { return s.neighbourRadius <= 1; }),
+                "The neighbourhood of a stage only covers the chunks next to it");
+
+  const Stage      stage  = slot.stage;
+  const StageInfo& info   = Stages[static_cast<int>(stage)];
+  const auto&      coords = slot.coords;
+
+  Neighbourhood neighbourhood{};
+  neighbourhood[4] = &slot;
+
+  bool ready = true;
+  for (int dz = -info.neighbourRadius; dz <= info.neighbourRadius; ++dz) {
+    for (int dx = -info.neighbourRadius; dx <= info.neighbourRadius; ++dx) {
+      if (dx == 0 && dz == 0) continue;
+
+      const ChunkCoords neighbourCoords{coords.x + dx, coords.z + dz};
+      Slot*             neighbour = FindSlot(neighbourCoords);
+      if (!neighbour) {
+        missingNeighbours.push_back(neighbourCoords);
+        ready = false;
+        continue;
+      }
+
+      // Having reached this stage means having finished the one before it
+      neighbour->target = std::max(neighbour->target, stage);
+      if (neighbour->stage < stage || neighbour->running || neighbour->discarded ||
+          neighbour->restart)
+        ready = false;
+      neighbourhood[(dx + 1) + (dz + 1) * 3] = neighbour;
+    }
+  }
+  if (!ready) return false;
+
+  for (std::size_t i = 0; i < neighbourhood.size(); ++i) {
+    if (i != 4 && neighbourhood[i]) ++const_cast<Slot*>(neighbourhood[i])->readers;
+  }
+  slot.running = true;
+  ++mRunningCount;
+
+  mThreadPool.Enqueue([this, &slot, neighbourhood, stage, &info] {
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    info.run({mColumnCache, mSpillBuffers, slot, neighbourhood});
+    const auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::scoped_lock lock(mCompletionsMutex);
+    mCompletions.push_back(
+        {slot.coords, stage, std::chrono::duration<float, std::milli>(t1 - t0).count()});
+  });
+  return true;
+}
+
+void GenerationPipeline::ReceiveCompletions() {
+  std::vector<Completion> completions;
+  {
+    std::scoped_lock lock(mCompletionsMutex);
+    std::swap(completions, mCompletions);
+  }
+
+  for (const auto& [coords, stage, milliseconds] : completions) {
+    // Running slots and the ones they read are never erased
+    Slot& slot   = *mSlots.at(coords);
+    slot.running = false;
+    slot.stage   = static_cast<Stage>(static_cast<int>(stage) + 1);
+    --mRunningCount;
+
+    const int radius = Stages[static_cast<int>(stage)].neighbourRadius;
+    for (int dz = -radius; dz <= radius; ++dz) {
+      for (int dx = -radius; dx <= radius; ++dx) {
+        if (dx != 0 || dz != 0) --mSlots.at({coords.x + dx, coords.z + dz})->readers;
+      }
+    }
+
+    auto& stats = mStageStats[static_cast<int>(stage)];
+    ++stats.chunks;
+    stats.milliseconds += milliseconds;
+  }
+}
+
+void GenerationPipeline::Prune(const std::function<bool(const ChunkCoords&)>& discard) {
+  for (auto it = mSlots.begin(); it != mSlots.end();) {
+    Slot& slot = *it->second;
+    if (!discard(it->first)) {
+      ++it;
+      continue;
+    }
+    if (slot.running || slot.readers > 0) {
+      slot.discarded = true;
+      ++it;
+      continue;
+    }
+    if (slot.requested) --mPendingCount;
+    mSpillBuffers.Erase(it->first);
+    it = mSlots.erase(it);
+  }
+}
+
+void GenerationPipeline::Shape(const StageContext& context) {
+  ChunkData& chunk   = *context.slot.chunk;
+  const auto columns = context.columnCache.GetColumns(chunk.GetChunkCoords());
+
+  const glm::ivec3 origin = chunk.LocalToWorldCoords({});
+  DensityField     densityField;
+  densityField.Sample(*context.columnCache.GetSeed(), *columns, {origin.x, origin.z});
+  ShapeFromDensity(chunk, densityField, context.slot.heightmap);
+}
+
+void GenerationPipeline::ShapeFromDensity(ChunkData&          chunk,
+                                          const DensityField& densityField,
+                                          Heightmap&          heightmap) {
+  DensityField::Column density;
+  for (int z = 0; z < ChunkData::ChunkSize.z; ++z) {
+    for (int x = 0; x < ChunkData::ChunkSize.x; ++x) {
+      chunk.SetBlockTypeAtLocalCoords({x, 0, z}, BlockType::Bedrock);
+
+      densityField.GetColumn(x, z, density);
+      int height = 0;
+      for (int y = 1; y < ChunkData::ChunkSize.y; ++y) {
+        if (density[y] <= 0.f) continue;
+        chunk.SetBlockTypeAtLocalCoords({x, y, z}, BlockType::Stone);
+        height = y;
+      }
+      heightmap[HeightmapIndex(x, z)] = static_cast<int16_t>(height);
+    }
+  }
+}
+
+void GenerationPipeline::Water(const StageContext& context) {
+  ChunkData& chunk = *context.slot.chunk;
+  for (int z = 0; z < ChunkData::ChunkSize.z; ++z) {
+    for (int x = 0; x < ChunkData::ChunkSize.x; ++x) {
+      for (int y = context.slot.heightmap[HeightmapIndex(x, z)] + 1; y <= Seed::SeaLevel; ++y) {
+        chunk.SetBlockTypeAtLocalCoords({x, y, z}, BlockType::Water);
+      }
+    }
+  }
+}
+
+void GenerationPipeline::Surface(const StageContext& context) {
+  ChunkData& chunk = *context.slot.chunk;
+  for (int z = 0; z < ChunkData::ChunkSize.z; ++z) {
+    for (int x = 0; x < ChunkData::ChunkSize.x; ++x) {
+      const int height = context.slot.heightmap[HeightmapIndex(x, z)];
+      if (height < 1) continue;
+
+      // Grass does not grow under water
+      const bool dry = height >= Seed::SeaLevel;
+      chunk.SetBlockTypeAtLocalCoords({x, height, z}, dry ? BlockType::Grass : BlockType::Dirt);
+      // Caves and overhangs can leave air below the top block
+      for (int y = std::max(1, height - SoilDepth); y < height; ++y) {
+        if (chunk.GetBlockTypeAtLocalCoords({x, y, z}) == BlockType::Stone) {
+          chunk.SetBlockTypeAtLocalCoords({x, y, z}, BlockType::Dirt);
+        }
+      }
+    }
+  }
+}
+
+void GenerationPipeline::Features(const StageContext& context) {
+  const auto& size = ChunkData::ChunkSize;
+
+  // Heights of columns up to a chunk outside of this one
+  const auto HeightAt = [&](int x, int z) -> int {
+    const int dx = x < 0 ? -1 : (x >= size.x ? 1 : 0);
+    const int dz = z < 0 ? -1 : (z >= size.z ? 1 : 0);
+    return context.neighbourhood[(dx + 1) + (dz + 1) * 3]
+        ->heightmap[HeightmapIndex(x - dx * size.x, z - dz * size.z)];
+  };
+
+  FeaturePlacer placer(*context.slot.chunk, context.columnCache.GetSeed()->GetSeed());
+  placer.PlaceTrees(HeightAt);
+  context.spillBuffers.Store(context.slot.coords, std::move(placer.GetSpills()));
+}
+
+void GenerationPipeline::Spills(const StageContext& context) {
+  ChunkData& chunk = *context.slot.chunk;
+  FeaturePlacer::ApplySpills(chunk, context.spillBuffers.Collect(context.slot.coords));
+
+  // Last stage, nothing writes to the chunk after this
+  chunk.Compact();
+}
+
+void GenerationPipeline::Debug() {
+  ImGui::LabelText("Generating Chunks", "%zu, %zu stages running", mSlots.size(), mRunningCount);
+  for (int i = 0; i < StageCount; ++i) {
+    const auto& stats = mStageStats[i];
+    ImGui::LabelText(Stages[i].name,
+                     "%.3fms per chunk, %zu chunks",
+                     stats.chunks == 0 ? 0.f : stats.milliseconds / stats.chunks,
+                     stats.chunks);
+  }
+  ImGui::LabelText("Spill Buffers",
+                   "%zu chunks, %.1f KB",
+                   mSpillBuffers.GetChunkCount(),
+                   mSpillBuffers.GetMemoryUsage() / 1024.f);
+
+  if (ImGui::Button("Benchmark Shape")) BenchmarkShape();
+  if (mShapeBenchmark) {
+    ImGui::LabelText("Heightmap Shape", "%.2fms per chunk", mShapeBenchmark->heightmapMilliseconds);
+    ImGui::LabelText("Lattice Density", "%.2fms per chunk", mShapeBenchmark->latticeMilliseconds);
+    ImGui::LabelText("Exact Density",
+                     "%.2fms per chunk, %.2f%% blocks differ",
+                     mShapeBenchmark->exactMilliseconds,
+                     mShapeBenchmark->mismatchedBlocks * 100.f);
+  }
+}
+
+void GenerationPipeline::BenchmarkShape() {
+  static constexpr int ChunkCount = 4;
+
+  const auto           snapshot = mColumnCache.GetSeed();
+  const Seed&          seed     = *snapshot;
+  const auto&          size     = ChunkData::ChunkSize;
+  ShapeBenchmark       benchmark{.chunks = ChunkCount};
+  Seed::ColumnGrid     columns;
+  DensityField         densityField;
+  DensityField::Column density;
+  Heightmap            heightmap;
+  std::size_t          mismatches = 0;
+
+  using Clock = std::chrono::high_resolution_clock;
+  const auto Milliseconds = [](Clock::time_point t0, Clock::time_point t1) {
+    return std::chrono::duration<float, std::milli>(t1 - t0).count() / ChunkCount;
+  };
+
+  for (int i = 0; i < ChunkCount; ++i) {
+    const ChunkCoords coords{i * 7, -i * 5};
+    const glm::ivec2  origin{coords.x * size.x, coords.z * size.z};
+    ChunkData         heightmapChunk(coords);
+    ChunkData         latticeChunk(coords);
+    ChunkData         exactChunk(coords);
+
+    // The 2D shaping the chunks were generated with before, height from continentalness alone
+    const auto t0 = Clock::now();
+    seed.SampleColumns(
+        glm::vec2(origin), {size.x, size.z}, 1.0f, columns, Seed::ContinentalnessField);
+    for (int z = 0; z < size.z; ++z) {
+      for (int x = 0; x < size.x; ++x) {
+        const float terrainHeight =
+            Seed::SurfaceHeight(columns.continentalness[columns.Index(x, z)], 1.f, 0.f);
+        const int height = std::clamp((int)terrainHeight, 0, size.y - 1);
+        for (int y = 1; y <= height; ++y) {
+          heightmapChunk.SetBlockTypeAtLocalCoords({x, y, z}, BlockType::Stone);
+        }
+      }
+    }
+
+    const auto t1 = Clock::now();
+    seed.SampleColumns(glm::vec2(origin), {size.x, size.z}, 1.0f, columns);
+    densityField.Sample(seed, columns, origin);
+    ShapeFromDensity(latticeChunk, densityField, heightmap);
+
+    // Every block samples the 3D noise itself
+    const auto t2 = Clock::now();
+    seed.SampleColumns(glm::vec2(origin), {size.x, size.z}, 1.0f, columns);
+    for (int z = 0; z < size.z; ++z) {
+      for (int x = 0; x < size.x; ++x) {
+        const std::size_t column        = columns.Index(x, z);
+        const float       erosion       = columns.erosion[column];
+        const float       surfaceHeight = Seed::SurfaceHeight(
+            columns.continentalness[column], erosion, columns.peaksAndValleys[column]);
+        for (int y = 1; y < size.y; ++y) {
+          const glm::vec3 p{origin.x + x, y, origin.y + z};
+          density[y] = Seed::Density(static_cast<float>(y),
+                                     surfaceHeight,
+                                     Seed::Overhang(erosion),
+                                     seed.DetailNoise(p),
+                                     seed.CaveNoise(p));
+          if (density[y] > 0.f) exactChunk.SetBlockTypeAtLocalCoords({x, y, z}, BlockType::Stone);
+        }
+      }
+    }
+    const auto t3 = Clock::now();
+
+    benchmark.heightmapMilliseconds += Milliseconds(t0, t1);
+    benchmark.latticeMilliseconds += Milliseconds(t1, t2);
+    benchmark.exactMilliseconds += Milliseconds(t2, t3);
+
+    for (int z = 0; z < size.z; ++z) {
+      for (int x = 0; x < size.x; ++x) {
+        for (int y = 1; y < size.y; ++y) {
+          mismatches += latticeChunk.GetBlockTypeAtLocalCoords({x, y, z}) !=
+                        exactChunk.GetBlockTypeAtLocalCoords({x, y, z});
+        }
+      }
+    }
+  }
+
+  benchmark.mismatchedBlocks =
+      static_cast<float>(mismatches) / (ChunkCount * static_cast<float>(ChunkData::BlockCount));
+  mShapeBenchmark = benchmark;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
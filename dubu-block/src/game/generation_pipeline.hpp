@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "game/chunk_data.hpp"
+#include "game/column_cache.hpp"
+#include "game/density_field.hpp"
+#include "game/feature_placer.hpp"
+#include "util/thread_pool.hpp"
+
+namespace dubu::block {
+
+// Generates chunks in stages on the worker threads. Every stage is a pass over the data of one
+// chunk that may read the chunks around it, and a chunk only runs a stage once the neighbours it
+// declares have finished the stage before it. Neighbours that were never requested are generated
+// as far as needed. A chunk is never written while a stage of another chunk reads it, and every
+// chunk is generated once, features that reach into a chunk are applied to it from SpillBuffers.
+class GenerationPipeline {
+public:
+  enum class Stage : uint8_t { Shape, Water, Surface, Features, Spills, Done };
+  static constexpr int StageCount = static_cast<int>(Stage::Done);
+
+  GenerationPipeline(ColumnCache& columnCache, ThreadPool& threadPool);
+
+  void Request(const ChunkCoords& coords);
+
+  // Dispatches every stage that is ready to run and hands out the requested chunks that finished
+  // all stages. Call it from the thread that requests chunks.
+  void Update(std::vector<std::unique_ptr<ChunkData>>& finishedChunks);
+
+  // Forgets the chunks discard returns true for, requested or not. Chunks that are busy are
+  // forgotten as soon as they are done.
+  void Prune(const std::function<bool(const ChunkCoords&)>& discard);
+
+  // Requested chunks that have not been handed out yet
+  std::size_t GetPendingCount() const { return mPendingCount; }
+
+  void Debug();
+
+private:
+  using Heightmap = std::array<int16_t, ChunkData::ChunkSize.x * ChunkData::ChunkSize.z>;
+
+  struct Slot {
+    Slot(const ChunkCoords& coords)
+        : coords(coords)
+        , chunk(std::make_unique<ChunkData>(coords)) {}
+
+    ChunkCoords coords;
+    // Handed out once the chunk is done, the rest of the slot stays behind so the neighbours
+    // still see the chunk as done
+    std::unique_ptr<ChunkData> chunk;
+    // Highest solid block of every column, written by the Shape stage
+    Heightmap heightmap{};
+    // The next stage to run, stages keep running until stage reaches target
+    Stage stage     = Stage::Shape;
+    Stage target    = Stage::Shape;
+    bool  requested = false;
+    bool  running   = false;
+    bool  discarded = false;
+    // Requested again after being discarded while busy, starts over from Shape once idle
+    bool restart = false;
+    int  readers = 0;
+  };
+
+  // Chunks around the one a stage runs on, indexed like ChunkSnapshot::Neighbourhood. Only the
+  // neighbours within the radius the stage declares are set.
+  using Neighbourhood = std::array<const Slot*, 9>;
+
+  struct StageContext {
+    ColumnCache&         columnCache;
+    SpillBuffers&        spillBuffers;
+    Slot&                slot;
+    const Neighbourhood& neighbourhood;
+  };
+
+  struct StageInfo {
+    const char* name;
+    // Chunks within this many chunks have to have finished the previous stage
+    int         neighbourRadius;
+    void (*run)(const StageContext& context);
+  };
+
+  struct Completion {
+    ChunkCoords coords;
+    Stage       stage;
+    float       milliseconds;
+  };
+
+  struct StageStats {
+    std::size_t chunks       = 0;
+    float       milliseconds = 0.f;
+  };
+
+  struct ShapeBenchmark {
+    int   chunks                = 0;
+    float heightmapMilliseconds = 0.f;
+    float latticeMilliseconds   = 0.f;
+    float exactMilliseconds     = 0.f;
+    // Share of the blocks that are solid in one of the lattice and exact densities but not both
+    float mismatchedBlocks      = 0.f;
+  };
+
+  static void Shape(const StageContext& context);
+  static void Water(const StageContext& context);
+  static void Surface(const StageContext& context);
+  static void Features(const StageContext& context);
+  static void Spills(const StageContext& context);
+
+  // Fills the chunk with stone where the density is positive
+  static void ShapeFromDensity(ChunkData&          chunk,
+                               const DensityField& densityField,
+                               Heightmap&          heightmap);
+
+  static constexpr std::array<StageInfo, StageCount> Stages{{
+      {"Shape", 0, &Shape},
+      {"Water", 0, &Water},
+      {"Surface", 0, &Surface},
+      // Trees look at the ground around them, which can be in the next chunk over
+      {"Features", 1, &Features},
+      // Nothing can spill into a chunk once its neighbours have placed their features
+      {"Spills", 1, &Spills},
+  }};
+
+  bool TryDispatch(Slot& slot, std::vector<ChunkCoords>& missingNeighbours);
+  void ReceiveCompletions();
+  void BenchmarkShape();
+
+  Slot* FindSlot(const ChunkCoords& coords) {
+    if (auto it = mSlots.find(coords); it != mSlots.end()) return it->second.get();
+    return nullptr;
+  }
+
+  ColumnCache& mColumnCache;
+  ThreadPool&  mThreadPool;
+
+  // Slots are allocated separately so the workers can hold on to them while the map grows
+  std::unordered_map<ChunkCoords, std::unique_ptr<Slot>> mSlots;
+  std::size_t                                            mPendingCount = 0;
+  std::size_t                                            mRunningCount = 0;
+
+  SpillBuffers mSpillBuffers;
+
+  std::vector<Completion> mCompletions;
+  std::mutex              mCompletionsMutex;
+
+  std::array<StageStats, StageCount> mStageStats{};
+  std::optional<ShapeBenchmark>      mShapeBenchmark;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
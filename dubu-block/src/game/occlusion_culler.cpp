@@ -0,0 +1,229 @@
+#include "occlusion_culler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <dubu_log/dubu_log.h>
+#include <imgui.h>
+
+#include "gl/shader.hpp"
+#include "io/io.hpp"
+
+namespace dubu::block {
+
+namespace {
+// Clip space w below which a box corner counts as behind the camera
+constexpr float NearW = 0.1f;
+}  // namespace
+
+OcclusionCuller::OcclusionCuller() {
+  VertexShader   vertexShader(ReadFile("assets/shaders/hiz.vert"));
+  FragmentShader fragmentShader(ReadFile("assets/shaders/hiz.frag"));
+  mDownsampleProgram.Link(vertexShader, fragmentShader);
+  if (const auto err = mDownsampleProgram.GetError()) {
+    DUBU_LOG_ERROR("shader program error: {}", *err);
+  }
+
+  glGenVertexArrays(1, &mVao);
+  glGenFramebuffers(1, &mFramebuffer);
+
+  for (auto& readback : mReadbacks) {
+    glGenBuffers(1, &readback.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER,
+                 ReadbackMaxSize * ReadbackMaxSize * sizeof(float),
+                 nullptr,
+                 GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+  for (auto& readback : mReadbacks) {
+    if (readback.fence) glDeleteSync(readback.fence);
+    glDeleteBuffers(1, &readback.buffer);
+  }
+  glDeleteTextures(1, &mDepthTexture);
+  glDeleteFramebuffers(1, &mFramebuffer);
+  glDeleteVertexArrays(1, &mVao);
+}
+
+void OcclusionCuller::BeginFrame() {
+  ++mFrame;
+  for (auto& readback : mReadbacks) {
+    if (!readback.fence) continue;
+
+    const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    if (readback.frame < mDepthFrame) continue;
+    const glm::ivec2 levelSize = LevelSize(readback.size, readback.level);
+    mDepth.resize(static_cast<std::size_t>(levelSize.x) * levelSize.y);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, mDepth.size() * sizeof(float), mDepth.data());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    mDepthSize           = readback.size;
+    mDepthLevel          = readback.level;
+    mDepthFrame          = readback.frame;
+    mDepthViewProjection = readback.viewProjection;
+  }
+}
+
+void OcclusionCuller::CaptureDepth(int width, int height, const glm::mat4& viewProjection) {
+  if (!mEnabled) return;
+
+  // Both readbacks still in flight, skip this frame rather than wait for the GPU
+  auto readback = std::find_if(
+      mReadbacks.begin(), mReadbacks.end(), [](const auto& r) { return r.fence == nullptr; });
+  if (readback == mReadbacks.end()) return;
+
+  if (mSize != glm::ivec2(width, height)) Resize(width, height);
+
+  glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+  BuildPyramid();
+
+  int level = 0;
+  while (level + 1 < mLevels && (LevelSize(mSize, level).x > ReadbackMaxSize ||
+                                 LevelSize(mSize, level).y > ReadbackMaxSize)) {
+    ++level;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glGetTexImage(GL_TEXTURE_2D, level, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  readback->fence          = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  readback->frame          = mFrame;
+  readback->size           = mSize;
+  readback->level          = level;
+  readback->viewProjection = viewProjection;
+}
+
+bool OcclusionCuller::IsOccluded(const AABB& aabb) const {
+  if (!mEnabled || mDepth.empty()) return false;
+
+  glm::vec3 ndcMin(1.0f), ndcMax(-1.0f);
+  for (int corner = 0; corner < 8; ++corner) {
+    const glm::vec4 position{corner & 1 ? aabb.max.x : aabb.min.x,
+                             corner & 2 ? aabb.max.y : aabb.min.y,
+                             corner & 4 ? aabb.max.z : aabb.min.z,
+                             1.0f};
+    const glm::vec4 clip = mDepthViewProjection * position;
+    if (clip.w < NearW) return false;
+
+    const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    ndcMin              = glm::min(ndcMin, ndc);
+    ndcMax              = glm::max(ndcMax, ndc);
+  }
+
+  // Parts of the box outside of the captured view have no depth to test against
+  if (ndcMin.x < -1.0f || ndcMin.y < -1.0f || ndcMax.x > 1.0f || ndcMax.y > 1.0f) return false;
+
+  const glm::ivec2 levelSize = LevelSize(mDepthSize, mDepthLevel);
+  const auto       ToTexel   = [&](float ndc, int size, int levelSize) {
+    const int pixel = static_cast<int>((ndc * 0.5f + 0.5f) * size);
+    return std::clamp(pixel >> mDepthLevel, 0, levelSize - 1);
+  };
+  const int x0 = ToTexel(ndcMin.x, mDepthSize.x, levelSize.x);
+  const int x1 = ToTexel(ndcMax.x, mDepthSize.x, levelSize.x);
+  const int y0 = ToTexel(ndcMin.y, mDepthSize.y, levelSize.y);
+  const int y1 = ToTexel(ndcMax.y, mDepthSize.y, levelSize.y);
+
+  // The box is hidden when its nearest point is behind the farthest depth of every texel it covers
+  const float nearestDepth = ndcMin.z * 0.5f + 0.5f;
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      if (nearestDepth <= mDepth[x + y * levelSize.x]) return false;
+    }
+  }
+  return true;
+}
+
+void OcclusionCuller::Debug() {
+  ImGui::Checkbox("Occlusion Culling", &mEnabled);
+  if (!mEnabled) mDepth.clear();
+  const glm::ivec2 levelSize = LevelSize(mDepthSize, mDepthLevel);
+  ImGui::LabelText("Hi-Z Readback",
+                   "%dx%d, level %d, %d frames old",
+                   mDepth.empty() ? 0 : levelSize.x,
+                   mDepth.empty() ? 0 : levelSize.y,
+                   mDepthLevel,
+                   static_cast<int>(mFrame - mDepthFrame));
+}
+
+void OcclusionCuller::Resize(int width, int height) {
+  mSize   = {width, height};
+  mLevels = static_cast<int>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+  // Every size gets a fresh texture so no levels of the previous size are left behind, the levels
+  // are specified one by one as immutable storage needs OpenGL 4.2
+  glDeleteTextures(1, &mDepthTexture);
+  glGenTextures(1, &mDepthTexture);
+  glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+  for (int level = 0; level < mLevels; ++level) {
+    const glm::ivec2 levelSize = LevelSize(mSize, level);
+    glTexImage2D(GL_TEXTURE_2D,
+                 level,
+                 GL_DEPTH_COMPONENT32F,
+                 levelSize.x,
+                 levelSize.y,
+                 0,
+                 GL_DEPTH_COMPONENT,
+                 GL_FLOAT,
+                 nullptr);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mLevels - 1);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void OcclusionCuller::BuildPyramid() {
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  glDepthFunc(GL_ALWAYS);
+  glDisable(GL_CULL_FACE);
+
+  mDownsampleProgram.Use();
+  glUniform1i(mDownsampleProgram.GetUniformLocation("DEPTH"), 1);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+  glBindVertexArray(mVao);
+
+  for (int level = 1; level < mLevels; ++level) {
+    // Only the source level may be sampled while the next one is the render target
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mDepthTexture, level);
+
+    const glm::ivec2 levelSize = LevelSize(mSize, level);
+    glViewport(0, 0, levelSize.x, levelSize.y);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mLevels - 1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(0);
+
+  glEnable(GL_CULL_FACE);
+  glDepthFunc(GL_LESS);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+}  // namespace dubu::block
\ No newline at end of file
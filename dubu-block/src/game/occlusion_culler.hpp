@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gl/shader_program.hpp"
+#include "linalg/aabb.hpp"
+
+namespace dubu::block {
+
+// Occlusion culling against a hierarchical depth buffer. After the chunks are drawn their depth is
+// copied out of the default framebuffer and reduced on the GPU into a pyramid where every texel
+// holds the farthest depth below it. A coarse level is read back asynchronously, so boxes are
+// tested on the CPU against the depth of a frame or two ago, using the camera of that frame. Only
+// plain fragment shaders and pixel buffer reads are used, which software GL implementations
+// handle fine.
+class OcclusionCuller {
+public:
+  OcclusionCuller();
+  ~OcclusionCuller();
+
+  OcclusionCuller(const OcclusionCuller&)            = delete;
+  OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+  // Picks up the newest finished readback, call once per frame before testing any boxes
+  void BeginFrame();
+
+  // Builds the pyramid from the depth buffer of the current framebuffer, call right after the
+  // occluders have been drawn
+  void CaptureDepth(int width, int height, const glm::mat4& viewProjection);
+
+  // Conservative, boxes that cannot be judged from the available depth are never occluded
+  bool IsOccluded(const AABB& aabb) const;
+
+  void Debug();
+
+private:
+  // The coarsest level that is read back fits in ReadbackMaxSize x ReadbackMaxSize texels
+  static constexpr int ReadbackMaxSize = 128;
+
+  // size is the size of the captured framebuffer, level the pyramid level that was read back
+  struct Readback {
+    GLuint     buffer = 0;
+    GLsync     fence  = nullptr;
+    uint64_t   frame  = 0;
+    glm::ivec2 size   = {};
+    int        level  = 0;
+    glm::mat4  viewProjection;
+  };
+
+  void Resize(int width, int height);
+  void BuildPyramid();
+
+  static glm::ivec2 LevelSize(glm::ivec2 size, int level) {
+    return glm::max(glm::ivec2(size.x >> level, size.y >> level), glm::ivec2(1));
+  }
+
+  ShaderProgram mDownsampleProgram;
+  GLuint        mVao          = 0;
+  GLuint        mFramebuffer  = 0;
+  GLuint        mDepthTexture = 0;
+  glm::ivec2    mSize         = {};
+  int           mLevels       = 0;
+
+  std::array<Readback, 2> mReadbacks;
+  uint64_t                mFrame = 0;
+
+  // The latest depth that made it back to the CPU
+  std::vector<float> mDepth;
+  glm::ivec2         mDepthSize  = {};
+  int                mDepthLevel = 0;
+  uint64_t           mDepthFrame = 0;
+  glm::mat4          mDepthViewProjection;
+
+  bool mEnabled = true;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
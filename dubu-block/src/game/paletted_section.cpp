@@ -0,0 +1,143 @@
+#include "paletted_section.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace dubu::block {
+
+void PalettedSection::Set(std::size_t index, BlockType blockType) {
+  const auto it           = std::find(mPalette.begin(), mPalette.end(), blockType);
+  const auto paletteIndex = static_cast<uint8_t>(it - mPalette.begin());
+
+  if (it == mPalette.end()) {
+    mPalette.push_back(blockType);
+    if (mPalette.size() > (1u << mBitsPerBlock)) {
+      std::vector<uint8_t> remap(mPalette.size());
+      std::iota(remap.begin(), remap.end(), uint8_t{0});
+      Repack(BitsForPaletteSize(mPalette.size()), remap);
+    }
+  } else if (mBitsPerBlock == 0) {
+    return;
+  }
+
+  WriteIndex(mData, mBitsPerBlock, index, paletteIndex);
+}
+
+void PalettedSection::Fill(BlockType blockType) {
+  mPalette.assign(1, blockType);
+  mData.clear();
+  mData.shrink_to_fit();
+  mBitsPerBlock = 0;
+}
+
+void PalettedSection::Compact() {
+  if (mBitsPerBlock == 0) return;
+
+  std::vector<bool> used(mPalette.size(), false);
+  for (std::size_t i = 0; i < BlockCount; ++i) {
+    used[ReadIndex(mData, mBitsPerBlock, i)] = true;
+  }
+
+  std::vector<BlockType> palette;
+  std::vector<uint8_t>   remap(mPalette.size());
+  for (std::size_t i = 0; i < mPalette.size(); ++i) {
+    if (!used[i]) continue;
+    remap[i] = static_cast<uint8_t>(palette.size());
+    palette.push_back(mPalette[i]);
+  }
+
+  if (palette.size() == 1) {
+    Fill(palette.front());
+    return;
+  }
+
+  const auto bitsPerBlock = BitsForPaletteSize(palette.size());
+  if (palette.size() == mPalette.size() && bitsPerBlock == mBitsPerBlock) return;
+
+  Repack(bitsPerBlock, remap);
+  mPalette = std::move(palette);
+  mPalette.shrink_to_fit();
+}
+
+void PalettedSection::Repack(uint8_t bitsPerBlock, const std::vector<uint8_t>& remap) {
+  std::vector<uint64_t> data(BlockCount * bitsPerBlock / 64, 0);
+  for (std::size_t i = 0; i < BlockCount; ++i) {
+    const uint8_t paletteIndex = mBitsPerBlock == 0 ? 0 : ReadIndex(mData, mBitsPerBlock, i);
+    WriteIndex(data, bitsPerBlock, i, remap[paletteIndex]);
+  }
+  mData         = std::move(data);
+  mBitsPerBlock = bitsPerBlock;
+}
+
+void PalettedSection::Serialize(std::vector<uint8_t>& data) const {
+  data.push_back(mBitsPerBlock);
+  data.push_back(static_cast<uint8_t>(mPalette.size() - 1));
+  for (const auto blockType : mPalette) {
+    data.push_back(static_cast<uint8_t>(blockType));
+  }
+
+  // Rows of blocks are packed into whole words, so layered terrain repeats the same word a lot
+  for (std::size_t i = 0; i < mData.size();) {
+    std::size_t run = 1;
+    while (run < UINT8_MAX && i + run < mData.size() && mData[i + run] == mData[i]) ++run;
+
+    data.push_back(static_cast<uint8_t>(run));
+    const std::size_t offset = data.size();
+    data.resize(offset + sizeof(uint64_t));
+    std::memcpy(data.data() + offset, &mData[i], sizeof(uint64_t));
+    i += run;
+  }
+}
+
+bool PalettedSection::Deserialize(std::span<const uint8_t>& data) {
+  if (data.size() < 2) return false;
+  const uint8_t     bitsPerBlock = data[0];
+  const std::size_t paletteSize  = data[1] + std::size_t{1};
+  // Widths are 0 or a power of two up to a byte
+  if (bitsPerBlock > 8 || (bitsPerBlock & (bitsPerBlock - 1)) != 0) return false;
+  if (paletteSize > (1u << bitsPerBlock)) return false;
+  if (data.size() < 2 + paletteSize) return false;
+
+  std::vector<BlockType> palette(paletteSize);
+  for (std::size_t i = 0; i < paletteSize; ++i) {
+    palette[i] = static_cast<BlockType>(data[2 + i]);
+  }
+  std::span<const uint8_t> remaining = data.subspan(2 + paletteSize);
+
+  std::vector<uint64_t> words(BlockCount * bitsPerBlock / 64);
+  for (std::size_t i = 0; i < words.size();) {
+    if (remaining.size() < 1 + sizeof(uint64_t)) return false;
+    const std::size_t run = remaining[0];
+    if (run == 0 || i + run > words.size()) return false;
+
+    uint64_t word;
+    std::memcpy(&word, remaining.data() + 1, sizeof(uint64_t));
+    std::fill_n(words.begin() + i, run, word);
+    remaining = remaining.subspan(1 + sizeof(uint64_t));
+    i += run;
+  }
+
+  // Unused index values past the end of the palette would read outside of it
+  if (bitsPerBlock != 0 && paletteSize < (1u << bitsPerBlock)) {
+    for (std::size_t i = 0; i < BlockCount; ++i) {
+      if (ReadIndex(words, bitsPerBlock, i) >= paletteSize) return false;
+    }
+  }
+
+  mPalette      = std::move(palette);
+  mData         = std::move(words);
+  mBitsPerBlock = bitsPerBlock;
+  data          = remaining;
+  return true;
+}
+
+uint8_t PalettedSection::BitsForPaletteSize(std::size_t paletteSize) {
+  // Only power of two widths so an index never straddles two words
+  if (paletteSize <= 2) return 1;
+  if (paletteSize <= 4) return 2;
+  if (paletteSize <= 16) return 4;
+  return 8;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "game/block.hpp"
+
+namespace dubu::block {
+
+// Block storage for a 16x16x16 section of a chunk. Blocks are stored as bit-packed indices into a
+// small palette of the block types present in the section, uniform sections only store their
+// single block type.
+class PalettedSection {
+public:
+  static constexpr std::size_t BlockCount = 16 * 16 * 16;
+
+  PalettedSection(BlockType blockType = BlockType::Empty)
+      : mPalette{blockType} {}
+
+  BlockType Get(std::size_t index) const {
+    if (mBitsPerBlock == 0) return mPalette.front();
+    return mPalette[ReadIndex(mData, mBitsPerBlock, index)];
+  }
+
+  void Set(std::size_t index, BlockType blockType);
+  void Fill(BlockType blockType);
+
+  // Drops unused palette entries and shrinks the indices to the smallest width that fits
+  void Compact();
+
+  bool      IsUniform() const { return mBitsPerBlock == 0; }
+  BlockType GetUniformBlockType() const { return mPalette.front(); }
+
+  // Appends the palette and the indices to data, runs of equal index words are stored once
+  void Serialize(std::vector<uint8_t>& data) const;
+  // Reads a section written by Serialize from the front of data and advances data past it.
+  // Returns false and leaves the section untouched if data does not hold a valid section.
+  bool Deserialize(std::span<const uint8_t>& data);
+
+  std::size_t GetMemoryUsage() const {
+    return mPalette.capacity() * sizeof(BlockType) + mData.capacity() * sizeof(uint64_t);
+  }
+
+private:
+  void Repack(uint8_t bitsPerBlock, const std::vector<uint8_t>& remap);
+
+  static uint8_t BitsForPaletteSize(std::size_t paletteSize);
+
+  static inline uint8_t ReadIndex(const std::vector<uint64_t>& data,
+                                  uint8_t                      bitsPerBlock,
+                                  std::size_t                  index) {
+    const std::size_t bit = index * bitsPerBlock;
+    return static_cast<uint8_t>((data[bit / 64] >> (bit % 64)) & ((1ull << bitsPerBlock) - 1));
+  }
+  static inline void WriteIndex(std::vector<uint64_t>& data,
+                                uint8_t                bitsPerBlock,
+                                std::size_t            index,
+                                uint8_t                value) {
+    const std::size_t bit   = index * bitsPerBlock;
+    const std::size_t shift = bit % 64;
+    const uint64_t    mask  = ((1ull << bitsPerBlock) - 1) << shift;
+    data[bit / 64] = (data[bit / 64] & ~mask) | (static_cast<uint64_t>(value) << shift);
+  }
+
+  std::vector<BlockType> mPalette;
+  std::vector<uint64_t>  mData;
+  uint8_t                mBitsPerBlock = 0;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
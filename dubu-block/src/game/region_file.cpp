@@ -0,0 +1,135 @@
+#include "region_file.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <dubu_log/dubu_log.h>
+
+namespace dubu::block {
+
+RegionFile::RegionFile(const std::filesystem::path& path)
+    : mPath(path) {
+  if (!std::filesystem::exists(path)) {
+    Create(path);
+    return;
+  }
+
+  mFile.open(path, std::ios::in | std::ios::out | std::ios::binary);
+  if (mFile.is_open() && !ReadHeader()) {
+    DUBU_LOG_ERROR("{} is not a region file", path.string());
+    mFile.close();
+  }
+}
+
+bool RegionFile::Create(const std::filesystem::path& path) {
+  mFile.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!mFile.is_open()) {
+    DUBU_LOG_ERROR("Failed to create region file {}", path.string());
+    return false;
+  }
+
+  mHeader = {.magic = Magic, .version = Version, .entries = {}};
+  std::vector<char> sectors(HeaderSectors * SectorSize, 0);
+  std::memcpy(sectors.data(), &mHeader, sizeof(Header));
+  mFile.write(sectors.data(), sectors.size());
+  mFile.flush();
+  mUsedSectors.assign(HeaderSectors, true);
+  return mFile.good();
+}
+
+bool RegionFile::ReadHeader() {
+  std::error_code   error;
+  const std::size_t fileSize = std::filesystem::file_size(mPath, error);
+  if (error) return false;
+
+  mFile.read(reinterpret_cast<char*>(&mHeader), sizeof(Header));
+  if (!mFile || mHeader.magic != Magic || mHeader.version != Version) return false;
+
+  const std::size_t fileSectors = (fileSize + SectorSize - 1) / SectorSize;
+  mUsedSectors.assign(std::max<std::size_t>(HeaderSectors, fileSectors), false);
+  std::fill_n(mUsedSectors.begin(), HeaderSectors, true);
+  for (auto& entry : mHeader.entries) {
+    if (entry.size == 0) continue;
+
+    // Entries that point outside of the file were written by a save that did not finish
+    if (entry.sectorOffset < HeaderSectors ||
+        entry.sectorOffset + std::size_t{SectorCount(entry.size)} > mUsedSectors.size()) {
+      DUBU_LOG_ERROR("Dropping a chunk that is out of bounds in {}", mPath.string());
+      entry = {};
+      continue;
+    }
+    MarkSectors(entry, true);
+  }
+  return true;
+}
+
+std::span<const uint8_t> RegionFile::Read(const ChunkCoords& coords) {
+  const Entry& entry = mHeader.entries[EntryIndex(coords)];
+  if (entry.size == 0) return {};
+
+  const std::size_t begin = std::size_t{entry.sectorOffset} * SectorSize;
+  // Chunks written since the file was mapped can lie past the end of the mapping
+  if (begin + entry.size > mMapping.GetData().size()) {
+    mMapping.Open(mPath);
+    if (begin + entry.size > mMapping.GetData().size()) return {};
+  }
+  return mMapping.GetData().subspan(begin, entry.size);
+}
+
+bool RegionFile::Write(const ChunkCoords& coords, std::span<const uint8_t> payload) {
+  if (!IsOpen() || payload.empty() || payload.size() > UINT32_MAX) return false;
+
+  const auto  size        = static_cast<uint32_t>(payload.size());
+  const Entry written     = {Allocate(SectorCount(size)), size};
+  const auto  entryIndex  = EntryIndex(coords);
+  const auto  paddingSize = SectorCount(size) * SectorSize - size;
+
+  static constexpr std::array<char, SectorSize> Padding{};
+  mFile.seekp(std::size_t{written.sectorOffset} * SectorSize);
+  mFile.write(reinterpret_cast<const char*>(payload.data()), size);
+  mFile.write(Padding.data(), paddingSize);
+  // The entry is only written once the payload is there
+  mFile.seekp(offsetof(Header, entries) + entryIndex * sizeof(Entry));
+  mFile.write(reinterpret_cast<const char*>(&written), sizeof(Entry));
+  mFile.flush();
+
+  if (!mFile) {
+    DUBU_LOG_ERROR("Failed to write chunk to {}", mPath.string());
+    mFile.clear();
+    MarkSectors(written, false);
+    return false;
+  }
+
+  MarkSectors(mHeader.entries[entryIndex], false);
+  mHeader.entries[entryIndex] = written;
+  return true;
+}
+
+std::size_t RegionFile::GetChunkCount() const {
+  return std::ranges::count_if(mHeader.entries, [](const Entry& e) { return e.size != 0; });
+}
+
+uint32_t RegionFile::Allocate(uint32_t sectorCount) {
+  uint32_t run = 0;
+  for (uint32_t i = HeaderSectors; i < mUsedSectors.size(); ++i) {
+    run = mUsedSectors[i] ? 0 : run + 1;
+    if (run == sectorCount) {
+      const Entry entry = {i + 1 - sectorCount, sectorCount * static_cast<uint32_t>(SectorSize)};
+      MarkSectors(entry, true);
+      return entry.sectorOffset;
+    }
+  }
+
+  // Free sectors at the end of the file are extended
+  const auto sectorOffset = static_cast<uint32_t>(mUsedSectors.size()) - run;
+  mUsedSectors.resize(sectorOffset + sectorCount, false);
+  MarkSectors({sectorOffset, sectorCount * static_cast<uint32_t>(SectorSize)}, true);
+  return sectorOffset;
+}
+
+void RegionFile::MarkSectors(const Entry& entry, bool used) {
+  std::fill_n(mUsedSectors.begin() + entry.sectorOffset, SectorCount(entry.size), used);
+}
+
+}  // namespace dubu::block
\ No newline at end of file
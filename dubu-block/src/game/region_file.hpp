@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+#include "game/chunk_data.hpp"
+#include "io/mapped_file.hpp"
+
+namespace dubu::block {
+
+// RegionSize x RegionSize chunks stored in one file. The file starts with a header that holds the
+// offset and size of the payload of every chunk, the payloads follow aligned to whole sectors.
+// Payloads are read straight from a mapping of the file, so only the pages of the chunks that are
+// read are loaded from disk. Everything is stored in host byte order.
+class RegionFile {
+public:
+  static constexpr int         RegionSize = 32;
+  static constexpr std::size_t SectorSize = 4096;
+
+  static constexpr ChunkCoords ToRegionCoords(const ChunkCoords& coords) {
+    return {FloorDiv(coords.x, RegionSize), FloorDiv(coords.z, RegionSize)};
+  }
+
+  // Opens the region file at path and creates it if it does not exist yet
+  RegionFile(const std::filesystem::path& path);
+
+  RegionFile(const RegionFile&)            = delete;
+  RegionFile& operator=(const RegionFile&) = delete;
+
+  // False if the file could not be created or is not a region file
+  bool IsOpen() const { return mFile.is_open(); }
+
+  bool Contains(const ChunkCoords& coords) const {
+    return mHeader.entries[EntryIndex(coords)].size != 0;
+  }
+
+  // The payload of the chunk, empty if it is not stored. Only valid until the next Write.
+  std::span<const uint8_t> Read(const ChunkCoords& coords);
+  // The old payload of the chunk is only released once the new one is written
+  bool Write(const ChunkCoords& coords, std::span<const uint8_t> payload);
+
+  std::size_t GetChunkCount() const;
+  std::size_t GetFileSize() const { return mUsedSectors.size() * SectorSize; }
+
+private:
+  static constexpr std::array<char, 4> Magic   = {'D', 'B', 'R', 'G'};
+  static constexpr uint32_t            Version = 1;
+
+  struct Entry {
+    uint32_t sectorOffset = 0;
+    uint32_t size         = 0;
+  };
+  struct Header {
+    std::array<char, 4>                        magic;
+    uint32_t                                   version;
+    std::array<Entry, RegionSize * RegionSize> entries;
+  };
+  static constexpr uint32_t HeaderSectors = (sizeof(Header) + SectorSize - 1) / SectorSize;
+
+  static constexpr int FloorDiv(int a, int b) { return a >= 0 ? a / b : (a + 1) / b - 1; }
+
+  static constexpr std::size_t EntryIndex(const ChunkCoords& coords) {
+    const ChunkCoords region = ToRegionCoords(coords);
+    return (coords.x - region.x * RegionSize) + (coords.z - region.z * RegionSize) * RegionSize;
+  }
+  static constexpr uint32_t SectorCount(uint32_t size) {
+    return static_cast<uint32_t>((size + SectorSize - 1) / SectorSize);
+  }
+
+  bool Create(const std::filesystem::path& path);
+  bool ReadHeader();
+
+  // First free run of sectorCount sectors, the file grows if there is none
+  uint32_t Allocate(uint32_t sectorCount);
+  void     MarkSectors(const Entry& entry, bool used);
+
+  std::filesystem::path mPath;
+  std::fstream          mFile;
+  MappedFile            mMapping;
+  Header                mHeader{};
+  std::vector<bool>     mUsedSectors;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "curve.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include <dubu_log/dubu_log.h>
+
+namespace dubu::block {
+
+namespace {
+// Samples between two table entries when measuring the error of the table
+constexpr int ErrorSamplesPerEntry = 8;
+}  // namespace
+
+Curve::Curve(const char* label, const std::array<ImVec2, 16> startValues)
+    : mLabel(label)
+    , mPoints(startValues) {
+  // Same default as the editor gives an empty curve, so values are valid before the first Draw
+  if (mPoints[0].x <= ImGui::CurveTerminator) {
+    mPoints[0]   = {0, 0};
+    mPoints[1]   = {1, 1};
+    mPoints[2].x = ImGui::CurveTerminator;
+  }
+  Bake();
+}
+
+bool Curve::Draw() {
+  ImGui::Curve(mLabel,
+               {ImGui::CalcItemWidth(), 200},
+               (int)mPoints.size(),
+               mPoints.data(),
+               &mSelection,
+               {0, 0},
+               {1, 1});
+
+  // Not every edit in the editor reports itself as a modification, so compare the points instead
+  const bool edited = std::memcmp(mPoints.data(), mBakedPoints.data(), sizeof(mPoints)) != 0;
+  if (edited) Bake();
+
+  ImGui::LabelText("Lookup Error", "%g", mLutError);
+  return edited;
+}
+
+float Curve::ExactValue(float alpha) const {
+  // The spline reads before the first and past the last point, so those ends are held flat
+  int pointCount = 0;
+  while (pointCount < (int)mPoints.size() && mPoints[pointCount].x >= 0) pointCount++;
+  if (pointCount == 0) return 0;
+  if (alpha <= mPoints[0].x) return mPoints[0].y;
+  if (alpha >= mPoints[pointCount - 1].x) return mPoints[pointCount - 1].y;
+
+  return ImGui::CurveValueSmooth(alpha, (int)mPoints.size(), mPoints.data());
+}
+
+void Curve::Bake() {
+  mBakedPoints = mPoints;
+
+  for (int i = 0; i < LutSize; ++i) {
+    mLut[i] = ExactValue(static_cast<float>(i) / (LutSize - 1));
+  }
+
+  mLutError = 0.f;
+  for (int i = 0; i <= (LutSize - 1) * ErrorSamplesPerEntry; ++i) {
+    const float alpha = static_cast<float>(i) / ((LutSize - 1) * ErrorSamplesPerEntry);
+    mLutError         = std::max(mLutError, std::abs(Value(alpha) - ExactValue(alpha)));
+  }
+  if (mLutError > LutTolerance) {
+    DUBU_LOG_ERROR("Curve {} lookup table is off by {}", mLabel, mLutError);
+  }
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -1,36 +1,49 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 
+#include <imgui.h>
+
 #include "imgui/imgui_curve.hpp"
 
 namespace dubu::block {
 
+// A curve from [0, 1] to [0, 1] that can be edited in ImGui. Values are looked up in a table baked
+// from the smooth spline through the points, which is rebaked whenever the points change.
 class Curve {
 public:
+  static constexpr int   LutSize      = 1024;
+  static constexpr float LutTolerance = 1e-3f;
+
   Curve(const char*                  label,
-        const std::array<ImVec2, 16> startValues = {{{ImGui::CurveTerminator, 0}}})
-      : mLabel(label)
-      , mPoints(startValues) {}
-
-  void Draw() {
-    ImGui::Curve(mLabel,
-                 {ImGui::CalcItemWidth(), 200},
-                 (int)mPoints.size(),
-                 mPoints.data(),
-                 &mSelection,
-                 {0, 0},
-                 {1, 1});
-  }
+        const std::array<ImVec2, 16> startValues = {{{ImGui::CurveTerminator, 0}}});
+
+  // Returns true if the points were edited and the table rebaked
+  bool Draw();
 
   inline float Value(float alpha) const {
-    return ImGui::CurveValueSmooth(alpha, (int)mPoints.size(), mPoints.data());
+    const float position = std::clamp(alpha, 0.f, 1.f) * (LutSize - 1);
+    const int   index    = std::min(static_cast<int>(position), LutSize - 2);
+    const float fraction = position - static_cast<float>(index);
+    return mLut[index] + (mLut[index + 1] - mLut[index]) * fraction;
   }
 
+  // The spline itself, slow but exact
+  float ExactValue(float alpha) const;
+
+  // Largest difference between Value and ExactValue, measured when the table was baked
+  float GetLutError() const { return mLutError; }
+
 private:
-  const char*            mLabel;
-  int                    mSelection = -1;
-  std::array<ImVec2, 16> mPoints{{{ImGui::CurveTerminator, 0}}};
+  void Bake();
+
+  const char*                mLabel;
+  int                        mSelection = -1;
+  std::array<ImVec2, 16>     mPoints{{{ImGui::CurveTerminator, 0}}};
+  std::array<ImVec2, 16>     mBakedPoints{};
+  std::array<float, LutSize> mLut{};
+  float                      mLutError = 0.f;
 };
 
 }  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "seed.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace dubu::block {
+
+namespace {
+// Evaluates the noise at every sample position and remaps it from [-1, 1] to [0, 1] through the
+// curve. Each step runs over the whole grid before the next one starts.
+void SampleField(const FastNoiseLite&      noise,
+                 const Curve&              curve,
+                 float                     sign,
+                 const std::vector<float>& sampleX,
+                 const std::vector<float>& sampleZ,
+                 std::vector<float>&       values) {
+  const std::size_t count = sampleX.size();
+  values.resize(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    values[i] = noise.GetNoise(sampleX[i], sampleZ[i]);
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    values[i] = (sign * values[i]) * 0.5f + 0.5f;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    values[i] = curve.Value(values[i]);
+  }
+}
+
+void ResetSamples(glm::vec2 origin, glm::ivec2 size, float spacing, Seed::ColumnGrid& grid) {
+  grid.sampleX.resize(static_cast<std::size_t>(size.x) * size.y);
+  grid.sampleZ.resize(grid.sampleX.size());
+  for (int z = 0; z < size.y; ++z) {
+    float* sampleX = grid.sampleX.data() + grid.Index(0, z);
+    float* sampleZ = grid.sampleZ.data() + grid.Index(0, z);
+    for (int x = 0; x < size.x; ++x) {
+      sampleX[x] = origin.x + static_cast<float>(x) * spacing;
+      sampleZ[x] = origin.y + static_cast<float>(z) * spacing;
+    }
+  }
+}
+}  // namespace
+
+void Seed::SampleColumns(glm::vec2   origin,
+                         glm::ivec2  size,
+                         float       spacing,
+                         ColumnGrid& grid,
+                         uint32_t    fields) const {
+  grid.size = size;
+  grid.continentalness.clear();
+  grid.erosion.clear();
+  grid.peaksAndValleys.clear();
+
+  ResetSamples(origin, size, spacing, grid);
+
+  if (fields & ContinentalnessField) {
+    SampleField(continentalnessNoise,
+                continentalnessCurve,
+                1.0f,
+                grid.sampleX,
+                grid.sampleZ,
+                grid.continentalness);
+  }
+  if (fields & ErosionField) {
+    SampleField(erosionNoise, erosionCurve, 1.0f, grid.sampleX, grid.sampleZ, grid.erosion);
+  }
+  if (fields & PeaksAndValleysField) {
+    // Warping moves the sample positions, so this field goes last
+    for (std::size_t i = 0; i < grid.sampleX.size(); ++i) {
+      peaksAndValleysDomainWarp.DomainWarp(grid.sampleX[i], grid.sampleZ[i]);
+    }
+    SampleField(peaksAndValleysNoise,
+                peaksAndValleysCurve,
+                -1.0f,
+                grid.sampleX,
+                grid.sampleZ,
+                grid.peaksAndValleys);
+  }
+}
+
+Seed::BenchmarkResult Seed::Benchmark() const {
+  static constexpr int        Iterations = 8;
+  static constexpr glm::ivec2 Size{64, 64};
+  static constexpr glm::vec2  Origin{-512.f, 256.f};
+
+  std::vector<float> continentalness(Size.x * Size.y);
+  std::vector<float> erosion(continentalness.size());
+  std::vector<float> peaksAndValleys(continentalness.size());
+  ColumnGrid         grid;
+  BenchmarkResult    result{.columns = Size.x * Size.y};
+
+  const auto t0 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < Iterations; ++i) {
+    for (int z = 0; z < Size.y; ++z) {
+      for (int x = 0; x < Size.x; ++x) {
+        const glm::vec2   p     = Origin + glm::vec2(x, z);
+        const std::size_t index = x + z * Size.x;
+        continentalness[index]  = Continentalness(p);
+        erosion[index]          = Erosion(p);
+        peaksAndValleys[index]  = PeaksAndValleys(p);
+      }
+    }
+  }
+  const auto t1 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < Iterations; ++i) {
+    SampleColumns(Origin, Size, 1.0f, grid);
+  }
+  const auto t2 = std::chrono::high_resolution_clock::now();
+
+  const float columns = static_cast<float>(result.columns * Iterations);
+  result.scalarColumnsPerSecond = columns / std::chrono::duration<float>(t1 - t0).count();
+  result.batchColumnsPerSecond  = columns / std::chrono::duration<float>(t2 - t1).count();
+
+  for (std::size_t i = 0; i < continentalness.size(); ++i) {
+    result.maxError = std::max({result.maxError,
+                                std::abs(continentalness[i] - grid.continentalness[i]),
+                                std::abs(erosion[i] - grid.erosion[i]),
+                                std::abs(peaksAndValleys[i] - grid.peaksAndValleys[i])});
+  }
+  return result;
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 #include <FastNoiseLite.h>
 #include <glm/glm.hpp>
 
@@ -9,6 +14,42 @@ namespace dubu::block {
 
 class Seed {
 public:
+  static constexpr int SeaLevel = 127;
+
+  // Blocks it takes for the density to fall by one above the surface
+  static constexpr float DensitySquash = 24.f;
+  // Cave noise above the threshold carves out caves
+  static constexpr float CaveThreshold = 0.45f;
+  static constexpr float CaveStrength  = 20.f;
+
+  // Fields filled by SampleColumns
+  enum ColumnFields : uint32_t {
+    ContinentalnessField = 1 << 0,
+    ErosionField         = 1 << 1,
+    PeaksAndValleysField = 1 << 2,
+    AllColumnFields      = ContinentalnessField | ErosionField | PeaksAndValleysField,
+  };
+
+  // Noise values for a grid of columns, row by row with x running fastest. Fields that were not
+  // requested are left empty. sampleX and sampleZ are scratch space for the sample positions.
+  struct ColumnGrid {
+    glm::ivec2         size{};
+    std::vector<float> continentalness;
+    std::vector<float> erosion;
+    std::vector<float> peaksAndValleys;
+    std::vector<float> sampleX;
+    std::vector<float> sampleZ;
+
+    std::size_t Index(int x, int z) const { return x + z * static_cast<std::size_t>(size.x); }
+  };
+
+  struct BenchmarkResult {
+    int   columns                = 0;
+    float scalarColumnsPerSecond = 0.f;
+    float batchColumnsPerSecond  = 0.f;
+    float maxError               = 0.f;
+  };
+
   Seed(int seed) {
     SetSeed(seed);
 
@@ -32,12 +73,29 @@ public:
     peaksAndValleysDomainWarp.SetFrequency(0.015f);
     peaksAndValleysDomainWarp.SetFractalType(FastNoiseLite::FractalType_DomainWarpIndependent);
     peaksAndValleysDomainWarp.SetFractalOctaves(3);
+
+    detailNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    detailNoise.SetFrequency(0.03f);
+    detailNoise.SetFractalType(FastNoiseLite::FractalType_FBm);
+    detailNoise.SetFractalOctaves(2);
+
+    caveNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    caveNoise.SetFrequency(0.025f);
   }
 
   float Continentalness(const glm::vec2& p) const {
     return continentalnessCurve.Value(continentalnessNoise.GetNoise(p.x, p.y) * 0.5f + 0.5f);
   }
 
+  // Height of the terrain surface without the 3D noise, the sea fills it up to SeaLevel. Peaks and
+  // valleys stand out where the erosion is low.
+  float TerrainHeight(const glm::vec2& p) const {
+    return SurfaceHeight(Continentalness(p), Erosion(p), PeaksAndValleys(p));
+  }
+  static float SurfaceHeight(float continentalness, float erosion, float peaksAndValleys) {
+    return 100 + continentalness * 64 + peaksAndValleys * (1 - erosion) * 32;
+  }
+
   float Erosion(const glm::vec2& p) const {
     return erosionCurve.Value(erosionNoise.GetNoise(p.x, p.y) * 0.5f + 0.5f);
   }
@@ -47,19 +105,63 @@ public:
     return peaksAndValleysCurve.Value((-peaksAndValleysNoise.GetNoise(p.x, p.y)) * 0.5f + 0.5f);
   }
 
+  // Strength of the 3D detail noise for a column, low erosion gives more overhangs
+  static float Overhang(float erosion) { return 0.15f + (1 - erosion) * 0.6f; }
+
+  float DetailNoise(const glm::vec3& p) const { return detailNoise.GetNoise(p.x, p.y, p.z); }
+  float CaveNoise(const glm::vec3& p) const { return caveNoise.GetNoise(p.x, p.y, p.z); }
+
+  // Density of a block at height y, solid where positive. The column terms come from
+  // SurfaceHeight and Overhang, the noise terms from DetailNoise and CaveNoise.
+  static float Density(float y, float surfaceHeight, float overhang, float detail, float cave) {
+    float density = (surfaceHeight - y) / DensitySquash + detail * overhang;
+    // Caves stay well below the sea floor, nothing would fill them with water
+    if (surfaceHeight > SeaLevel + 2 || y < surfaceHeight - 8) {
+      density -= std::max(0.f, cave - CaveThreshold) * CaveStrength;
+    }
+    return density;
+  }
+
+  // Samples the columns origin + (x, z) * spacing of a size.x by size.y grid. Gives the same values
+  // as the per column functions above, but evaluates one field at a time over the whole grid in
+  // flat loops over plain float arrays.
+  void SampleColumns(glm::vec2   origin,
+                     glm::ivec2  size,
+                     float       spacing,
+                     ColumnGrid& grid,
+                     uint32_t    fields = AllColumnFields) const;
+
+  // Times the per column functions against SampleColumns on the same grid
+  BenchmarkResult Benchmark() const;
+
+  int GetSeed() const { return mSeed; }
+  // Bumped whenever a curve is edited, together with the seed it identifies the generated terrain
+  uint32_t GetCurveVersion() const { return mCurveVersion; }
+
   void SetSeed(int seed) {
     mSeed = seed;
     continentalnessNoise.SetSeed(mSeed);
     erosionNoise.SetSeed(mSeed);
     peaksAndValleysNoise.SetSeed(mSeed);
     peaksAndValleysDomainWarp.SetSeed(mSeed);
+    detailNoise.SetSeed(mSeed);
+    caveNoise.SetSeed(mSeed + 1);
   }
 
   void Debug() {
     if (ImGui::DragInt("Seed", &mSeed)) SetSeed(mSeed);
-    continentalnessCurve.Draw();
-    erosionCurve.Draw();
-    peaksAndValleysCurve.Draw();
+    if (continentalnessCurve.Draw()) ++mCurveVersion;
+    if (erosionCurve.Draw()) ++mCurveVersion;
+    if (peaksAndValleysCurve.Draw()) ++mCurveVersion;
+
+    if (ImGui::Button("Benchmark Column Noise")) mBenchmark = Benchmark();
+    if (mBenchmark) {
+      ImGui::LabelText("Per Column Noise", "%.0f columns/s", mBenchmark->scalarColumnsPerSecond);
+      ImGui::LabelText("Batch Noise",
+                       "%.0f columns/s, max error %g",
+                       mBenchmark->batchColumnsPerSecond,
+                       mBenchmark->maxError);
+    }
   }
 
 private:
@@ -80,7 +182,12 @@ private:
   FastNoiseLite peaksAndValleysDomainWarp;
   Curve         peaksAndValleysCurve{"Peaks & Valleys"};
 
-  int mSeed = 1337;
+  FastNoiseLite detailNoise;
+  FastNoiseLite caveNoise;
+
+  int                            mSeed         = 1337;
+  uint32_t                       mCurveVersion = 0;
+  std::optional<BenchmarkResult> mBenchmark;
 };
 
 }  // namespace dubu::block
\ No newline at end of file
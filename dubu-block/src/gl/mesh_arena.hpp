@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+
+#include <dubu_log/dubu_log.h>
+#include <glad/glad.h>
+
+#include "game/chunk_vertex.hpp"
+#include "gl/staging_pool.hpp"
+#include "gl/staging_stream.hpp"
+#include "util/range_allocator.hpp"
+
+namespace dubu::block {
+
+// One large vertex and index buffer that chunk meshes are sub-allocated from, so every chunk can
+// be drawn from the same buffers with a single indirect draw call. The buffers double in size
+// when they run out of space. Meshes are written into a staging pool and copied into the arena on
+// the GPU, and the arena buffers are immutable storage where OpenGL 4.4 is available.
+class MeshArena {
+public:
+  using Vertex = ChunkVertex;
+
+  struct Allocation {
+    GLint   firstVertex = 0;
+    GLsizei vertexCount = 0;
+    GLuint  firstIndex  = 0;
+    GLsizei indexCount  = 0;
+  };
+
+  MeshArena(GLsizei vertexCapacity, GLsizei indexCapacity, GLsizeiptr stagingSize)
+      : mVertices(vertexCapacity)
+      , mIndices(indexCapacity)
+      , mStaging(stagingSize) {
+    glGenBuffers(1, &mVertexBuffer);
+    glGenBuffers(1, &mIndexBuffer);
+    CreateBuffer(mVertexBuffer, vertexCapacity * sizeof(Vertex));
+    CreateBuffer(mIndexBuffer, indexCapacity * sizeof(GLuint));
+  }
+
+  ~MeshArena() {
+    glDeleteBuffers(1, &mVertexBuffer);
+    glDeleteBuffers(1, &mIndexBuffer);
+  }
+
+  MeshArena(const MeshArena&)            = delete;
+  MeshArena& operator=(const MeshArena&) = delete;
+
+  Allocation Allocate(GLsizei vertexCount, GLsizei indexCount) {
+    const auto firstVertex = AllocateRange(mVertices, mVertexBuffer, sizeof(Vertex), vertexCount);
+    const auto firstIndex  = AllocateRange(mIndices, mIndexBuffer, sizeof(GLuint), indexCount);
+    return {.firstVertex = static_cast<GLint>(firstVertex),
+            .vertexCount = vertexCount,
+            .firstIndex  = firstIndex,
+            .indexCount  = indexCount};
+  }
+
+  void Free(const Allocation& allocation) {
+    mVertices.Free(allocation.firstVertex, allocation.vertexCount);
+    mIndices.Free(allocation.firstIndex, allocation.indexCount);
+  }
+
+  // Copies vertexCount vertices from sourceVertex on and indexCount indices from sourceIndex on
+  void Upload(const StagingStream<Vertex>& vertices,
+              GLint                        sourceVertex,
+              GLint                        firstVertex,
+              GLsizei                      vertexCount,
+              const StagingStream<GLuint>& indices,
+              GLuint                       sourceIndex,
+              GLuint                       firstIndex,
+              GLsizei                      indexCount) {
+    UploadRange(mVertexBuffer, firstVertex * sizeof(Vertex), vertices, sourceVertex, vertexCount);
+    UploadRange(mIndexBuffer, firstIndex * sizeof(GLuint), indices, sourceIndex, indexCount);
+  }
+
+  // Closes the uploads of this frame, call once per frame after they have been issued
+  void FenceUploads() {
+    mStaging.Fence();
+    mLastFrameBytes = mFrameBytes;
+    mFrameBytes     = 0;
+  }
+
+  // Moves geometry within the arena without a round trip through the CPU
+  void Copy(GLint   sourceVertex,
+            GLint   firstVertex,
+            GLsizei vertexCount,
+            GLuint  sourceIndex,
+            GLuint  firstIndex,
+            GLsizei indexCount) {
+    CopyBuffer(mVertexBuffer,
+               mVertexBuffer,
+               sourceVertex * sizeof(Vertex),
+               firstVertex * sizeof(Vertex),
+               vertexCount * sizeof(Vertex));
+    CopyBuffer(mIndexBuffer,
+               mIndexBuffer,
+               sourceIndex * sizeof(GLuint),
+               firstIndex * sizeof(GLuint),
+               indexCount * sizeof(GLuint));
+  }
+
+  GLuint GetVertexBuffer() const { return mVertexBuffer; }
+  GLuint GetIndexBuffer() const { return mIndexBuffer; }
+
+  std::size_t GetMemoryUsage() const {
+    return mVertices.GetUsed() * sizeof(Vertex) + mIndices.GetUsed() * sizeof(GLuint);
+  }
+  std::size_t GetCapacity() const {
+    return mVertices.GetCapacity() * sizeof(Vertex) + mIndices.GetCapacity() * sizeof(GLuint);
+  }
+  // Meshes are written into its pages on the workers
+  StagingPool&       GetStaging() { return mStaging; }
+  const StagingPool& GetStaging() const { return mStaging; }
+  GLsizeiptr         GetLastFrameBytes() const { return mLastFrameBytes; }
+
+  std::size_t GetFreeRangeCount() const {
+    return mVertices.GetFreeRangeCount() + mIndices.GetFreeRangeCount();
+  }
+
+private:
+  template <typename T>
+  void UploadRange(GLuint                  buffer,
+                   GLintptr                offset,
+                   const StagingStream<T>& stream,
+                   std::size_t             first,
+                   std::size_t             count) {
+    stream.ForEachPage(first, count, [&](const auto& page, std::size_t pageFirst, std::size_t n) {
+      const GLsizeiptr size = n * sizeof(T);
+      if (page.poolPage) {
+        mStaging.Submit(*page.poolPage);
+        CopyBuffer(mStaging.GetBuffer(),
+                   buffer,
+                   mStaging.GetPageOffset(*page.poolPage) + pageFirst * sizeof(T),
+                   offset,
+                   size);
+      } else {
+        // Without a persistent mapping or room in the pool the page is on the heap, let the driver
+        // stage it instead
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, page.data + pageFirst);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      }
+      offset      += size;
+      mFrameBytes += size;
+    });
+  }
+
+  static GLuint AllocateRange(RangeAllocator& allocator,
+                              GLuint&         buffer,
+                              std::size_t     elementSize,
+                              GLsizei         count) {
+    if (const auto offset = allocator.Allocate(count)) return *offset;
+
+    const uint32_t capacity    = allocator.GetCapacity();
+    const uint32_t newCapacity = std::max(capacity * 2, capacity + static_cast<uint32_t>(count));
+    DUBU_LOG_DEBUG("Growing mesh arena buffer to {} elements", newCapacity);
+
+    GLuint newBuffer;
+    glGenBuffers(1, &newBuffer);
+    CreateBuffer(newBuffer, newCapacity * elementSize);
+    CopyBuffer(buffer, newBuffer, 0, 0, capacity * elementSize);
+    glDeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+
+    allocator.Grow(newCapacity);
+    return *allocator.Allocate(count);
+  }
+
+  static void CreateBuffer(GLuint buffer, GLsizeiptr size) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (GLAD_GL_VERSION_4_4) {
+      glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    } else {
+      glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  static void CopyBuffer(
+      GLuint source, GLuint destination, GLintptr sourceOffset, GLintptr offset, GLsizeiptr size) {
+    if (size == 0) return;
+    glBindBuffer(GL_COPY_READ_BUFFER, source);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, offset, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  RangeAllocator mVertices;
+  RangeAllocator mIndices;
+  GLuint         mVertexBuffer;
+  GLuint         mIndexBuffer;
+
+  StagingPool mStaging;
+  GLsizeiptr  mFrameBytes     = 0;
+  GLsizeiptr  mLastFrameBytes = 0;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
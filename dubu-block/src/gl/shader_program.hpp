@@ -2,7 +2,9 @@
 
 #include <optional>
 #include <string>
+#include <unordered_map>
 
+#include <dubu_log/dubu_log.h>
 #include <glad/glad.h>
 
 namespace dubu::block {
@@ -17,6 +19,7 @@ public:
     mProgram = glCreateProgram();
     (AttachShader(shaders), ...);
     glLinkProgram(mProgram);
+    ReflectUniforms();
   }
 
   std::optional<std::string> GetError() {
@@ -35,17 +38,63 @@ public:
   GLint GetAttributeLocation(std::string_view name) {
     return glGetAttribLocation(mProgram, name.data());
   }
-  GLint GetUniformLocation(std::string_view name) {
-    return glGetUniformLocation(mProgram, name.data());
+  // Served from the locations reflected at link time, unknown names resolve to -1 which glUniform*
+  // silently ignores
+  GLint GetUniformLocation(std::string_view name) const {
+    if (auto it = mUniformLocations.find(name); it != mUniformLocations.end()) return it->second;
+    return -1;
+  }
+
+  void BindUniformBlock(std::string_view name, GLuint binding) {
+    const GLuint blockIndex = glGetUniformBlockIndex(mProgram, name.data());
+    if (blockIndex == GL_INVALID_INDEX) {
+      DUBU_LOG_ERROR("uniform block {} not found", name);
+      return;
+    }
+    glUniformBlockBinding(mProgram, blockIndex, binding);
   }
 
   GLuint mProgram;
 
 private:
+  struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  void ReflectUniforms() {
+    mUniformLocations.clear();
+
+    GLint uniformCount = 0;
+    glGetProgramiv(mProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+    for (GLint i = 0; i < uniformCount; ++i) {
+      char    buffer[256];
+      GLsizei length;
+      GLint   size;
+      GLenum  type;
+      glGetActiveUniform(mProgram, i, sizeof(buffer), &length, &size, &type, buffer);
+
+      // Uniforms inside of blocks have no location
+      const GLint location = glGetUniformLocation(mProgram, buffer);
+      if (location < 0) continue;
+
+      // Arrays are reported as NAME[0], make them available by their plain name as well
+      std::string name(buffer, length);
+      mUniformLocations.emplace(name, location);
+      if (name.ends_with("[0]")) {
+        mUniformLocations.emplace(name.substr(0, name.size() - 3), location);
+      }
+    }
+  }
+
   template <typename T>
   void AttachShader(T&& shader) {
     glAttachShader(mProgram, shader.mShader);
   }
+
+  std::unordered_map<std::string, GLint, StringHash, std::equal_to<>> mUniformLocations;
 };
 
 }  // namespace dubu::block
\ No newline at end of file
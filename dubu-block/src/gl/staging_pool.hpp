@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace dubu::block {
+
+// A persistently mapped, coherent upload buffer split into pages, which the workers write into
+// directly and the main thread copies into their destination on the GPU. A page is handed out
+// again once its writer has released it and the GPU has passed the fence after the last copy out
+// of it. Without OpenGL 4.4 there is no persistent mapping and no pages are handed out.
+class StagingPool {
+public:
+  static constexpr GLsizeiptr PageSize = 64 * 1024;
+
+  StagingPool(GLsizeiptr size)
+      : mPages(size / PageSize) {
+    if (!GLAD_GL_VERSION_4_4) return;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &mBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, GetSize(), nullptr, flags);
+    mMapping = static_cast<std::byte*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, GetSize(), flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    mFreePages.reserve(mPages.size());
+    for (uint32_t page = static_cast<uint32_t>(mPages.size()); page-- > 0;) {
+      mFreePages.push_back(page);
+    }
+  }
+
+  ~StagingPool() {
+    for (const auto& fence : mFences) {
+      glDeleteSync(fence.sync);
+    }
+    if (mMapping) {
+      glBindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+      glUnmapBuffer(GL_COPY_READ_BUFFER);
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      glDeleteBuffers(1, &mBuffer);
+    }
+  }
+
+  StagingPool(const StagingPool&)            = delete;
+  StagingPool& operator=(const StagingPool&) = delete;
+
+  // Returns a page to write to, or nullopt if every page is in use. Safe to call from any thread.
+  std::optional<uint32_t> Acquire() {
+    std::scoped_lock lock(mMutex);
+    if (mFreePages.empty()) {
+      if (mMapping) mFallbacks.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    const uint32_t page = mFreePages.back();
+    mFreePages.pop_back();
+    mPages[page].owned = true;
+    return page;
+  }
+
+  // Gives back a page nothing more is copied out of. Safe to call from any thread.
+  void Release(uint32_t page) {
+    std::scoped_lock lock(mMutex);
+    mPages[page].owned = false;
+    if (mPages[page].fence == 0) mFreePages.push_back(page);
+  }
+
+  // Marks the page as read by a copy issued this frame
+  void Submit(uint32_t page) {
+    std::scoped_lock lock(mMutex);
+    if (mPages[page].fence == mFenceCount + 1) return;
+    mPages[page].fence = mFenceCount + 1;
+    mSubmittedPages.push_back(page);
+  }
+
+  // Closes the copies of this frame, call once per frame after they have been issued. Frees the
+  // released pages of the fences the GPU has passed.
+  void Fence() {
+    std::scoped_lock lock(mMutex);
+    while (!mFences.empty()) {
+      auto&        fence  = mFences.front();
+      const GLenum status = glClientWaitSync(fence.sync, 0, 0);
+      if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+      glDeleteSync(fence.sync);
+      for (const auto page : fence.pages) {
+        // Pages copied from again since are covered by a later fence
+        if (mPages[page].fence != fence.number) continue;
+        mPages[page].fence = 0;
+        if (!mPages[page].owned) mFreePages.push_back(page);
+      }
+      mFences.pop_front();
+    }
+
+    if (mSubmittedPages.empty()) return;
+    mFences.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+                       ++mFenceCount,
+                       std::move(mSubmittedPages)});
+    mSubmittedPages.clear();
+  }
+
+  std::byte* GetPageData(uint32_t page) const { return mMapping + page * PageSize; }
+  GLintptr   GetPageOffset(uint32_t page) const { return page * PageSize; }
+
+  GLuint GetBuffer() const { return mBuffer; }
+  bool   IsPersistent() const { return mMapping != nullptr; }
+
+  GLsizeiptr GetSize() const { return mPages.size() * PageSize; }
+  GLsizeiptr GetBytesInUse() const {
+    std::scoped_lock lock(mMutex);
+    return mMapping ? GetSize() - mFreePages.size() * PageSize : 0;
+  }
+  // Pages that could not be handed out because the pool was full
+  std::size_t GetFallbackCount() const { return mFallbacks.load(std::memory_order_relaxed); }
+
+private:
+  struct Page {
+    bool owned = false;
+    // Number of the fence after the last copy out of the page, 0 once the GPU has passed it
+    uint32_t fence = 0;
+  };
+  struct PendingFence {
+    GLsync                sync;
+    uint32_t              number;
+    std::vector<uint32_t> pages;
+  };
+
+  GLuint     mBuffer  = 0;
+  std::byte* mMapping = nullptr;
+
+  std::vector<Page>        mPages;
+  std::vector<uint32_t>    mFreePages;
+  std::vector<uint32_t>    mSubmittedPages;
+  std::deque<PendingFence> mFences;
+  uint32_t                 mFenceCount = 0;
+  std::atomic<std::size_t> mFallbacks  = 0;
+  mutable std::mutex       mMutex;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gl/staging_pool.hpp"
+
+namespace dubu::block {
+
+// A growable array that is written straight into the pages of a StagingPool, for data that is
+// written once and then copied into a GPU buffer. Pages come from the heap when there is no pool
+// or it is full. The elements are not meant to be read back, the mapping is write combined.
+template <typename T>
+class StagingStream {
+public:
+  static_assert(std::is_trivially_copyable_v<T> && StagingPool::PageSize % sizeof(T) == 0);
+  static constexpr std::size_t PageCapacity = StagingPool::PageSize / sizeof(T);
+
+  struct Page {
+    std::optional<uint32_t> poolPage;
+    std::unique_ptr<T[]>    heap;
+    T*                      data;
+  };
+
+  StagingStream(StagingPool* pool = nullptr)
+      : mPool(pool) {}
+
+  ~StagingStream() { ReleasePoolPages(); }
+
+  StagingStream(StagingStream&& other)
+      : mPool(other.mPool)
+      , mPages(std::move(other.mPages))
+      , mUsedPages(std::exchange(other.mUsedPages, 0))
+      , mSize(std::exchange(other.mSize, 0))
+      , mWrite(std::exchange(other.mWrite, nullptr))
+      , mPageEnd(std::exchange(other.mPageEnd, nullptr)) {
+    other.mPages.clear();
+  }
+  StagingStream& operator=(StagingStream&& other) {
+    if (this == &other) return *this;
+    ReleasePoolPages();
+    mPool      = other.mPool;
+    mPages     = std::move(other.mPages);
+    mUsedPages = std::exchange(other.mUsedPages, 0);
+    mSize      = std::exchange(other.mSize, 0);
+    mWrite     = std::exchange(other.mWrite, nullptr);
+    mPageEnd   = std::exchange(other.mPageEnd, nullptr);
+    other.mPages.clear();
+    return *this;
+  }
+
+  StagingStream(const StagingStream&)            = delete;
+  StagingStream& operator=(const StagingStream&) = delete;
+
+  void push_back(const T& value) {
+    if (mWrite == mPageEnd) NextPage();
+    *mWrite++ = value;
+    ++mSize;
+  }
+
+  std::size_t size() const { return mSize; }
+  bool        empty() const { return mSize == 0; }
+
+  // The pool pages go back to the pool, the heap pages are kept for the next elements
+  void clear() {
+    ReleasePoolPages();
+    std::erase_if(mPages, [](const Page& page) { return page.poolPage.has_value(); });
+    mUsedPages = 0;
+    mSize      = 0;
+    mWrite     = nullptr;
+    mPageEnd   = nullptr;
+  }
+
+  // Calls copy(page, first, count) for the part of each page that holds the elements
+  // [first, first + count), with first relative to the start of the page
+  template <typename Copy>
+  void ForEachPage(std::size_t first, std::size_t count, Copy&& copy) const {
+    while (count > 0) {
+      const std::size_t pageFirst = first % PageCapacity;
+      const std::size_t pageCount = std::min(count, PageCapacity - pageFirst);
+      copy(mPages[first / PageCapacity], pageFirst, pageCount);
+      first += pageCount;
+      count -= pageCount;
+    }
+  }
+
+private:
+  void NextPage() {
+    if (mUsedPages == mPages.size()) {
+      Page page{};
+      if (mPool) page.poolPage = mPool->Acquire();
+      if (page.poolPage) {
+        page.data = reinterpret_cast<T*>(mPool->GetPageData(*page.poolPage));
+      } else {
+        page.heap = std::make_unique_for_overwrite<T[]>(PageCapacity);
+        page.data = page.heap.get();
+      }
+      mPages.push_back(std::move(page));
+    }
+    mWrite   = mPages[mUsedPages++].data;
+    mPageEnd = mWrite + PageCapacity;
+  }
+
+  void ReleasePoolPages() {
+    for (const auto& page : mPages) {
+      if (page.poolPage) mPool->Release(*page.poolPage);
+    }
+  }
+
+  StagingPool*      mPool;
+  std::vector<Page> mPages;
+  std::size_t       mUsedPages = 0;
+  std::size_t       mSize      = 0;
+  T*                mWrite     = nullptr;
+  T*                mPageEnd   = nullptr;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
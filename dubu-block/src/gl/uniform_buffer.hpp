@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace dubu::block {
+
+// A uniform buffer holding a single std140 laid out T, the caller is responsible for matching the
+// padding rules of the block it is bound to.
+template <typename T>
+class UniformBuffer {
+public:
+  UniformBuffer() {
+    glGenBuffers(1, &mBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  ~UniformBuffer() { glDeleteBuffers(1, &mBuffer); }
+
+  UniformBuffer(const UniformBuffer&)            = delete;
+  UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+  void Update(const T& data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  void Bind(GLuint binding) const { glBindBufferBase(GL_UNIFORM_BUFFER, binding, mBuffer); }
+
+private:
+  GLuint mBuffer;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
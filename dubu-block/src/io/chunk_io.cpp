@@ -0,0 +1,181 @@
+#include "chunk_io.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include <imgui.h>
+
+namespace dubu::block {
+
+ChunkIo::ChunkIo(std::filesystem::path root, int seed)
+    : mStorage(std::move(root), seed)
+    , mSeed(seed)
+    , mThread([this] { WorkerLoop(); }) {}
+
+ChunkIo::~ChunkIo() {
+  {
+    std::scoped_lock lock(mMutex);
+    mStopping = true;
+  }
+  mRequestAdded.notify_one();
+  mThread.join();
+}
+
+void ChunkIo::Load(const ChunkCoords& coords, LoadCallback callback) {
+  ++mPendingLoads;
+  Enqueue({.type = Request::Type::Load, .coords = coords, .callback = std::move(callback)});
+}
+
+void ChunkIo::Save(const ChunkData& chunk) {
+  std::vector<uint8_t> payload;
+  chunk.Serialize(payload);
+  Enqueue({.type    = Request::Type::Save,
+           .coords  = chunk.GetChunkCoords(),
+           .payload = std::move(payload)});
+}
+
+void ChunkIo::SetSeed(int seed) {
+  mSeed = seed;
+  Enqueue({.type = Request::Type::SetSeed, .seed = seed});
+}
+
+void ChunkIo::Clear() {
+  Enqueue({.type = Request::Type::Clear});
+}
+
+void ChunkIo::Enqueue(Request&& request) {
+  {
+    std::scoped_lock lock(mMutex);
+    switch (request.type) {
+    case Request::Type::Save:
+      if (auto it = mQueuedSaves.find(request.coords); it != mQueuedSaves.end()) {
+        it->second->payload = std::move(request.payload);
+        ++mWindow.coalesced;
+        return;
+      }
+      mQueuedSaves[request.coords] = &mRequests.emplace_back(std::move(request));
+      break;
+    case Request::Type::SetSeed:
+    case Request::Type::Clear:
+      // Saves made after this belong to the new storage, they can not replace the ones before it
+      mQueuedSaves.clear();
+      mRequests.push_back(std::move(request));
+      break;
+    default:
+      mRequests.push_back(std::move(request));
+      break;
+    }
+  }
+  mRequestAdded.notify_one();
+}
+
+void ChunkIo::Update() {
+  std::vector<Completion> completions;
+  {
+    std::scoped_lock lock(mMutex);
+    std::swap(completions, mCompletions);
+
+    const auto now = Clock::now();
+    if (now - mWindowStart >= WindowDuration) {
+      mLastWindow        = std::exchange(mWindow, {});
+      mLastWindowSeconds = std::chrono::duration<float>(now - mWindowStart).count();
+      mWindowStart       = now;
+    }
+  }
+
+  for (auto& [callback, chunk] : completions) {
+    --mPendingLoads;
+    callback(std::move(chunk));
+  }
+}
+
+void ChunkIo::WorkerLoop() {
+  for (;;) {
+    Request request{};
+    {
+      std::unique_lock lock(mMutex);
+      mRequestAdded.wait(lock, [this] { return mStopping || !mRequests.empty(); });
+      // Every queued save is written before the thread stops
+      if (mRequests.empty()) return;
+
+      auto& front = mRequests.front();
+      if (auto it = mQueuedSaves.find(front.coords);
+          it != mQueuedSaves.end() && it->second == &front) {
+        mQueuedSaves.erase(it);
+      }
+      request = std::move(front);
+      mRequests.pop_front();
+
+      // Nobody is left to receive the chunk
+      if (mStopping && request.type == Request::Type::Load) continue;
+    }
+
+    std::unique_ptr<ChunkData> chunk;
+    switch (request.type) {
+    case Request::Type::Load:
+      chunk = mStorage.Load(request.coords);
+      break;
+    case Request::Type::Save:
+      mStorage.Save(request.coords, request.payload);
+      break;
+    case Request::Type::SetSeed:
+      mStorage.SetSeed(request.seed);
+      break;
+    case Request::Type::Clear:
+      mStorage.Clear();
+      break;
+    }
+    const float latency =
+        std::chrono::duration<float, std::milli>(Clock::now() - request.queuedAt).count();
+
+    {
+      std::scoped_lock lock(mMutex);
+      if (request.type == Request::Type::Load) {
+        ++mWindow.loads;
+        mCompletions.push_back({std::move(request.callback), std::move(chunk)});
+      } else if (request.type == Request::Type::Save) {
+        ++mWindow.saves;
+        mWindow.savedBytes += request.payload.size();
+      }
+      mWindow.latencySum += latency;
+      mWindow.latencyMax = std::max(mWindow.latencyMax, latency);
+      ++mWindow.latencySamples;
+      mStorageStats = mStorage.GetStats();
+    }
+  }
+}
+
+void ChunkIo::Debug() {
+  std::scoped_lock lock(mMutex);
+
+  const auto& window  = mLastWindow;
+  const float seconds = mLastWindowSeconds;
+  ImGui::LabelText("I/O Queue", "%zu requests, %zu loads", mRequests.size(), mPendingLoads);
+  ImGui::LabelText("I/O Throughput",
+                   "%.0f loads/s, %.0f saves/s, %.2f MB/s written",
+                   window.loads / seconds,
+                   window.saves / seconds,
+                   window.savedBytes / (1024.f * 1024.f * seconds));
+  ImGui::LabelText("I/O Coalesced Saves", "%.0f/s", window.coalesced / seconds);
+  ImGui::LabelText("I/O Queue Latency",
+                   "%.2fms average, %.2fms max",
+                   window.latencySamples == 0 ? 0.f : window.latencySum / window.latencySamples,
+                   window.latencyMax);
+
+  const auto& stats = mStorageStats;
+  ImGui::LabelText("Region Files",
+                   "%zu open, %zu chunks, %.2f MB",
+                   stats.regionCount,
+                   stats.chunkCount,
+                   stats.fileSize / (1024.f * 1024.f));
+  ImGui::LabelText("Chunk Loads",
+                   "%.3fms per chunk, %zu chunks",
+                   stats.loads == 0 ? 0.f : stats.loadMilliseconds / stats.loads,
+                   stats.loads);
+  ImGui::LabelText("Chunk Saves",
+                   "%.3fms per chunk, %.1f KB per chunk",
+                   stats.saves == 0 ? 0.f : stats.saveMilliseconds / stats.saves,
+                   stats.saves == 0 ? 0.f : stats.savedBytes / (1024.f * stats.saves));
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "game/chunk_data.hpp"
+#include "game/chunk_storage.hpp"
+
+namespace dubu::block {
+
+// Loads and saves chunks on a thread of its own, so the main thread never waits for the disk.
+// Requests run in the order they are made. Saves are written behind, a save of a chunk that is
+// still queued replaces the queued payload instead of writing the chunk twice. Callbacks are run
+// on the main thread by Update.
+class ChunkIo {
+public:
+  // chunk is nullptr if it was never saved
+  using LoadCallback = std::function<void(std::unique_ptr<ChunkData> chunk)>;
+
+  ChunkIo(std::filesystem::path root, int seed);
+  // Writes every queued save before returning, queued loads are dropped
+  ~ChunkIo();
+
+  ChunkIo(const ChunkIo&)            = delete;
+  ChunkIo& operator=(const ChunkIo&) = delete;
+
+  void Load(const ChunkCoords& coords, LoadCallback callback);
+  // The chunk is serialized right away, it can be edited or destroyed once this returns
+  void Save(const ChunkData& chunk);
+
+  // Run after the requests made before them, see ChunkStorage
+  void SetSeed(int seed);
+  void Clear();
+  int  GetSeed() const { return mSeed; }
+
+  // Runs the callbacks of the loads that finished since the last call
+  void Update();
+
+  std::size_t GetPendingLoadCount() const { return mPendingLoads; }
+
+  void Debug();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    enum class Type { Load, Save, SetSeed, Clear };
+
+    Type                 type;
+    ChunkCoords          coords   = {};
+    std::vector<uint8_t> payload  = {};
+    LoadCallback         callback = {};
+    int                  seed     = 0;
+    Clock::time_point    queuedAt = Clock::now();
+  };
+
+  struct Completion {
+    LoadCallback               callback;
+    std::unique_ptr<ChunkData> chunk;
+  };
+
+  // Counters of the requests that finished in one window of WindowDuration
+  struct Window {
+    std::size_t loads          = 0;
+    std::size_t saves          = 0;
+    std::size_t savedBytes     = 0;
+    std::size_t coalesced      = 0;
+    float       latencySum     = 0.f;
+    float       latencyMax     = 0.f;
+    std::size_t latencySamples = 0;
+  };
+  static constexpr auto WindowDuration = std::chrono::seconds(1);
+
+  void Enqueue(Request&& request);
+  void WorkerLoop();
+
+  // Only touched on the I/O thread
+  ChunkStorage mStorage;
+  // Only touched on the main thread
+  int         mSeed;
+  std::size_t mPendingLoads = 0;
+
+  std::deque<Request> mRequests;
+  // The queued save of every chunk, requests stay in place while the deque grows and shrinks
+  std::unordered_map<ChunkCoords, Request*> mQueuedSaves;
+  std::vector<Completion>                   mCompletions;
+  bool                                      mStopping = false;
+
+  Window              mWindow;
+  Window              mLastWindow;
+  float               mLastWindowSeconds = 1.f;
+  Clock::time_point   mWindowStart       = Clock::now();
+  ChunkStorage::Stats mStorageStats;
+
+  mutable std::mutex      mMutex;
+  std::condition_variable mRequestAdded;
+
+  // Declared last so the thread starts once everything it touches is constructed
+  std::thread mThread;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <dubu_log/dubu_log.h>
+
+namespace dubu::block {
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+
+  HANDLE file = CreateFileW(path.c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+
+  const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    DUBU_LOG_ERROR("Failed to map {}", path.string());
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  mFile    = file;
+  mMapping = mapping;
+  mData    = static_cast<const uint8_t*>(data);
+  mSize    = static_cast<std::size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mData) UnmapViewOfFile(mData);
+  if (mMapping) CloseHandle(mMapping);
+  if (mFile) CloseHandle(mFile);
+  mData    = nullptr;
+  mSize    = 0;
+  mMapping = nullptr;
+  mFile    = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) return false;
+
+  struct stat status;
+  if (fstat(file, &status) != 0 || status.st_size == 0) {
+    close(file);
+    return false;
+  }
+
+  void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+  // The mapping stays valid after the descriptor is closed
+  close(file);
+  if (data == MAP_FAILED) {
+    DUBU_LOG_ERROR("Failed to map {}", path.string());
+    return false;
+  }
+
+  mData = static_cast<const uint8_t*>(data);
+  mSize = static_cast<std::size_t>(status.st_size);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mData) munmap(const_cast<uint8_t*>(mData), mSize);
+  mData = nullptr;
+  mSize = 0;
+}
+
+#endif
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace dubu::block {
+
+// Read-only memory mapping of a whole file. Pages are only read from disk once they are touched.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile&)            = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps the file as it is now, writes that grow the file afterwards are not part of the mapping.
+  // Returns false if the file could not be mapped.
+  bool Open(const std::filesystem::path& path);
+  void Close();
+
+  std::span<const uint8_t> GetData() const { return {mData, mSize}; }
+
+private:
+  const uint8_t* mData = nullptr;
+  std::size_t    mSize = 0;
+#ifdef _WIN32
+  void* mFile    = nullptr;
+  void* mMapping = nullptr;
+#endif
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -10,31 +10,33 @@ struct AABB {
   glm::vec3 min;
   glm::vec3 max;
 
-  bool IsOutside(const Plane& plane) const {
+  bool IsOutside(const Plane& plane) const { return ProjectOnto(plane.n).x >= plane.d; }
+
+  // The smallest and largest distance along n of any point in the box
+  glm::vec2 ProjectOnto(const glm::vec3& n) const {
     float minD, maxD;
-    if (plane.n.x > 0.0f) {
-      minD = plane.n.x * min.x;
-      maxD = plane.n.x * max.x;
+    if (n.x > 0.0f) {
+      minD = n.x * min.x;
+      maxD = n.x * max.x;
     } else {
-      minD = plane.n.x * max.x;
-      maxD = plane.n.x * min.x;
+      minD = n.x * max.x;
+      maxD = n.x * min.x;
     }
-    if (plane.n.y > 0.0f) {
-      minD += plane.n.y * min.y;
-      maxD += plane.n.y * max.y;
+    if (n.y > 0.0f) {
+      minD += n.y * min.y;
+      maxD += n.y * max.y;
     } else {
-      minD += plane.n.y * max.y;
-      maxD += plane.n.y * min.y;
+      minD += n.y * max.y;
+      maxD += n.y * min.y;
     }
-    if (plane.n.z > 0.0f) {
-      minD += plane.n.z * min.z;
-      maxD += plane.n.z * max.z;
+    if (n.z > 0.0f) {
+      minD += n.z * min.z;
+      maxD += n.z * max.z;
     } else {
-      minD += plane.n.z * max.z;
-      maxD += plane.n.z * min.z;
+      minD += n.z * max.z;
+      maxD += n.z * min.z;
     }
-
-    return minD >= plane.d;
+    return {minD, maxD};
   }
 };
 
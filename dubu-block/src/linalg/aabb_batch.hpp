@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "linalg/aabb.hpp"
+
+namespace dubu::block {
+
+// Boxes stored as a structure of arrays so several of them can be tested against a plane at once.
+// The arrays are padded to a multiple of Width, padding boxes are never reported as visible.
+class AABBBatch {
+public:
+  static constexpr std::size_t Width = 8;
+
+  void Clear() {
+    mSize = 0;
+    for (auto* component : {&mMinX, &mMinY, &mMinZ, &mMaxX, &mMaxY, &mMaxZ}) {
+      component->clear();
+    }
+  }
+
+  std::size_t Add(const AABB& aabb) {
+    if (mSize % Width == 0) {
+      for (auto* component : {&mMinX, &mMinY, &mMinZ, &mMaxX, &mMaxY, &mMaxZ}) {
+        component->resize(mSize + Width, 0.f);
+      }
+    }
+    mMinX[mSize] = aabb.min.x;
+    mMinY[mSize] = aabb.min.y;
+    mMinZ[mSize] = aabb.min.z;
+    mMaxX[mSize] = aabb.max.x;
+    mMaxY[mSize] = aabb.max.y;
+    mMaxZ[mSize] = aabb.max.z;
+    return mSize++;
+  }
+
+  AABB Get(std::size_t index) const {
+    return {{mMinX[index], mMinY[index], mMinZ[index]},
+            {mMaxX[index], mMaxY[index], mMaxZ[index]}};
+  }
+
+  std::size_t Size() const { return mSize; }
+  // Size rounded up to a multiple of Width
+  std::size_t PaddedSize() const { return mMinX.size(); }
+
+  const float* MinX() const { return mMinX.data(); }
+  const float* MinY() const { return mMinY.data(); }
+  const float* MinZ() const { return mMinZ.data(); }
+  const float* MaxX() const { return mMaxX.data(); }
+  const float* MaxY() const { return mMaxY.data(); }
+  const float* MaxZ() const { return mMaxZ.data(); }
+
+private:
+  std::vector<float> mMinX, mMinY, mMinZ;
+  std::vector<float> mMaxX, mMaxY, mMaxZ;
+  std::size_t        mSize = 0;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "frustum.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DUBU_BLOCK_FRUSTUM_SSE
+#include <emmintrin.h>
+#endif
+
+namespace dubu::block {
+
+namespace {
+// The corner of each box that reaches furthest against the plane normal, the box is outside when
+// even that corner is in front of the plane
+struct PlaneCorner {
+  const float* x;
+  const float* y;
+  const float* z;
+};
+
+PlaneCorner SelectCorner(const AABBBatch& batch, const Plane& plane) {
+  return {plane.n.x > 0.0f ? batch.MinX() : batch.MaxX(),
+          plane.n.y > 0.0f ? batch.MinY() : batch.MaxY(),
+          plane.n.z > 0.0f ? batch.MinZ() : batch.MaxZ()};
+}
+}  // namespace
+
+void Frustum::CullBatch(const AABBBatch& batch, std::vector<uint32_t>& visibleMask) const {
+  visibleMask.assign((batch.PaddedSize() + 31) / 32, 0);
+
+  std::array<PlaneCorner, 6> corners;
+  for (std::size_t p = 0; p < planes.size(); ++p) {
+    corners[p] = SelectCorner(batch, planes[p]);
+  }
+
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= batch.PaddedSize(); i += 8) {
+    __m256 outside = _mm256_setzero_ps();
+    for (std::size_t p = 0; p < planes.size(); ++p) {
+      const auto& [x, y, z] = corners[p];
+      const __m256 distance = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].n.x), _mm256_loadu_ps(x + i)),
+                        _mm256_mul_ps(_mm256_set1_ps(planes[p].n.y), _mm256_loadu_ps(y + i))),
+          _mm256_mul_ps(_mm256_set1_ps(planes[p].n.z), _mm256_loadu_ps(z + i)));
+      outside = _mm256_or_ps(
+          outside, _mm256_cmp_ps(distance, _mm256_set1_ps(planes[p].d), _CMP_GE_OQ));
+    }
+    const uint32_t visible = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xffu;
+    visibleMask[i / 32] |= visible << (i % 32);
+  }
+#elif defined(DUBU_BLOCK_FRUSTUM_SSE)
+  for (; i + 4 <= batch.PaddedSize(); i += 4) {
+    __m128 outside = _mm_setzero_ps();
+    for (std::size_t p = 0; p < planes.size(); ++p) {
+      const auto& [x, y, z] = corners[p];
+      const __m128 distance =
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].n.x), _mm_loadu_ps(x + i)),
+                                _mm_mul_ps(_mm_set1_ps(planes[p].n.y), _mm_loadu_ps(y + i))),
+                     _mm_mul_ps(_mm_set1_ps(planes[p].n.z), _mm_loadu_ps(z + i)));
+      outside = _mm_or_ps(outside, _mm_cmpge_ps(distance, _mm_set1_ps(planes[p].d)));
+    }
+    const uint32_t visible = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xfu;
+    visibleMask[i / 32] |= visible << (i % 32);
+  }
+#endif
+  for (; i < batch.PaddedSize(); ++i) {
+    bool outside = false;
+    for (std::size_t p = 0; p < planes.size(); ++p) {
+      const auto& [x, y, z] = corners[p];
+      outside |= planes[p].n.x * x[i] + planes[p].n.y * y[i] + planes[p].n.z * z[i] >= planes[p].d;
+    }
+    visibleMask[i / 32] |= static_cast<uint32_t>(!outside) << (i % 32);
+  }
+
+  // Padding boxes are not part of the batch
+  for (std::size_t j = batch.Size(); j < batch.PaddedSize(); ++j) {
+    visibleMask[j / 32] &= ~(1u << (j % 32));
+  }
+}
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -1,17 +1,22 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <imgui.h>
 
 #include "linalg/aabb.hpp"
+#include "linalg/aabb_batch.hpp"
 #include "linalg/plane.hpp"
 
 namespace dubu::block {
 
 class Frustum {
 public:
+  enum class Containment { Outside, Intersecting, Inside };
+
   Frustum(glm::mat4 inverseViewProjection) {
     glm::vec4 nearBottomLeft  = inverseViewProjection * glm::vec4{-1, -1, 1, 1};
     glm::vec4 nearBottomRight = inverseViewProjection * glm::vec4{1, -1, 1, 1};
@@ -47,6 +52,20 @@ public:
     return false;
   }
 
+  // Tests every box of the batch, bit i of visibleMask is set when box i is not outside. Uses
+  // AVX2 or SSE when the target supports them.
+  void CullBatch(const AABBBatch& batch, std::vector<uint32_t>& visibleMask) const;
+
+  Containment Classify(const AABB& aabb) const {
+    auto containment = Containment::Inside;
+    for (auto& plane : planes) {
+      const glm::vec2 distances = aabb.ProjectOnto(plane.n);
+      if (distances.x >= plane.d) return Containment::Outside;
+      if (distances.y >= plane.d) containment = Containment::Intersecting;
+    }
+    return containment;
+  }
+
   void Debug() {
     ImGui::InputFloat3("Left Plane Normal", &planes[0].n.x, "%.3f", ImGuiInputTextFlags_ReadOnly);
     ImGui::InputFloat3("Right Plane Normal", &planes[1].n.x, "%.3f", ImGuiInputTextFlags_ReadOnly);
@@ -1,4 +1,6 @@
+#include <array>
 #include <memory>
+#include <optional>
 
 #include <dubu_event/dubu_event.h>
 #include <dubu_log/dubu_log.h>
@@ -11,7 +13,12 @@
 
 #include "camera/freefly_camera.hpp"
 #include "game/atlas.hpp"
+#include "game/cave_culler.hpp"
+#include "game/chunk_culler.hpp"
 #include "game/chunk_manager.hpp"
+#include "game/chunk_renderer.hpp"
+#include "game/far_terrain.hpp"
+#include "game/occlusion_culler.hpp"
 #include "generator/seed.hpp"
 #include "gl/debug_drawer.hpp"
 #include "gl/shader.hpp"
@@ -19,6 +26,7 @@
 #include "imgui/dock_space.hpp"
 #include "input/input.hpp"
 #include "io/io.hpp"
+#include "linalg/aabb_batch.hpp"
 #include "linalg/frustum.hpp"
 
 namespace dubu::block {
@@ -27,10 +35,16 @@ class App : public dubu::opengl_app::AppBase, public dubu::event::EventSubscribe
 public:
   App()
       : dubu::opengl_app::AppBase({.appName = "dubu-block"}) {}
-  virtual ~App() = default;
+  virtual ~App() {
+    // Join the generation workers before the seed they sample from is destroyed, and release the
+    // chunk meshes before the arena they are allocated from
+    mChunkManager.reset();
+    mFarTerrain.reset();
+  }
 
 protected:
   virtual void Init() override {
+    glfwGetFramebufferSize(mWindow->GetGLFWHandle(), &mWidth, &mHeight);
     Subscribe<dubu::window::EventResize>(
         [&](const auto& e) {
           mWidth  = e.width;
@@ -55,33 +69,28 @@ protected:
 
     mAtlas = std::make_unique<Atlas>(mBlockDescriptions);
 
-    mChunkManager = std::make_unique<ChunkManager>(*mAtlas, mBlockDescriptions, mSeed);
-
-    CalculateChunkIndexTable();
-  }
-
-  void CalculateChunkIndexTable() {
-    mChunkIndexTable.clear();
-
-    mChunkIndexTable.push_back({0, 0});
-    for (int d = 1; d <= mRenderDistance; ++d) {
-      for (int x = -d; x <= d; ++x) {
-        int z = d;
-        mChunkIndexTable.push_back({x, z});
-      }
-      for (int z = d; z >= -d; --z) {
-        int x = d;
-        mChunkIndexTable.push_back({x, z});
-      }
-      for (int x = d; x >= -d; --x) {
-        int z = -d;
-        mChunkIndexTable.push_back({x, z});
-      }
-      for (int z = -d; z < d; ++z) {
-        int x = -d;
-        mChunkIndexTable.push_back({x, z});
-      }
+    std::array<glm::vec3, MaxBlockTypes> blockColors;
+    blockColors.fill({1, 1, 1});
+    for (const auto& [id, block] : mBlockDescriptions.GetBlockDescriptions()) {
+      blockColors[static_cast<std::size_t>(id)] = block.GetColor();
     }
+
+    const auto& atlasTiles = mAtlas->GetTiles();
+
+    mChunkProgram.Use();
+    mChunkProgram.BindUniformBlock("FrameUniforms", ChunkRenderer::FrameUniformsBinding);
+    glUniform4fv(mChunkProgram.GetUniformLocation("ATLAS_TILES"),
+                 static_cast<GLsizei>(atlasTiles.size()),
+                 glm::value_ptr(atlasTiles.front()));
+    glUniform3fv(mChunkProgram.GetUniformLocation("BLOCK_COLORS"),
+                 static_cast<GLsizei>(blockColors.size()),
+                 glm::value_ptr(blockColors.front()));
+
+    mChunkRenderer   = std::make_unique<ChunkRenderer>();
+    mOcclusionCuller = std::make_unique<OcclusionCuller>();
+    mChunkManager    = std::make_unique<ChunkManager>(
+        *mAtlas, mBlockDescriptions, mSeed, mChunkRenderer->GetArena());
+    mFarTerrain      = std::make_unique<FarTerrain>(mSeed);
   }
 
   virtual void Update() override {
@@ -90,7 +99,7 @@ protected:
     const float  deltaTime    = time - previousTime;
     previousTime              = time;
 
-    mChunkManager->Update(camera.GetPosition(), time);
+    mChunkManager->Update(camera.GetPosition(), mRenderDistance, time);
 
     Input::Update();
     camera.Update(deltaTime);
@@ -107,72 +116,136 @@ protected:
         glm::perspective(glm::radians(60.0f),
                          static_cast<float>(mWidth) / mHeight,
                          0.1f,
-                         static_cast<float>((mRenderDistance + 1) * Chunk::ChunkSize.z));
+                         static_cast<float>((mRenderDistance + 1) * ChunkData::ChunkSize.z));
     const glm::mat4 viewProjection = projection * view;
-    const glm::mat4 model          = glm::mat4(1.0f);
 
-    int triangles    = 0;
-    int chunksDrawn  = 0;
-    int chunksCulled = 0;
+    // With far terrain the fog reaches out to the horizon instead of the edge of the chunks
+    float     fogDistance = static_cast<float>(mRenderDistance * ChunkData::ChunkSize.z);
+    glm::vec2 fogControl  = mFogControl;
+    mFarTerrain->Update(camera.GetPosition(),
+                        static_cast<float>((mRenderDistance - 1) * ChunkData::ChunkSize.z));
+    if (mFarTerrain->IsEnabled()) {
+      fogDistance  = mFarTerrain->GetHorizon();
+      fogControl.y = fogDistance * fogDistance / 3.0f;
+
+      // Drawn with its own far plane, the chunks are drawn on top after clearing the depth
+      const glm::mat4 farProjection = glm::perspective(glm::radians(60.0f),
+                                                       static_cast<float>(mWidth) / mHeight,
+                                                       1.0f,
+                                                       fogDistance * 1.5f);
+      mFarTerrain->Draw(farProjection * view, camera.GetPosition(), mSkyColor, fogControl);
+      glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    int triangles      = 0;
+    int chunksDrawn    = 0;
+    int chunksCulled   = 0;
+    int sectionsCulled = 0;
+    int chunksOccluded = 0;
+    int sectionsHidden = 0;
 
     Frustum frustum(glm::inverse(viewProjection));
 
     mAtlas->Bind(GL_TEXTURE0);
-    for (const auto& [i, j] : mChunkIndexTable) {
-      const auto& cameraPosition = camera.GetPosition();
-      const int   x = static_cast<int>(std::roundf(cameraPosition.x / Chunk::ChunkSize.x)) + i;
-      const int   z = static_cast<int>(std::roundf(cameraPosition.z / Chunk::ChunkSize.z)) + j;
-
-      const float dx = (x + 0.5f) - cameraPosition.x / (float)(Chunk::ChunkSize.x);
-      const float dz = (z + 0.5f) - cameraPosition.z / (float)(Chunk::ChunkSize.z);
-      const float d2 = dx * dx + dz * dz;
-      if (d2 > mRenderDistance * mRenderDistance) continue;
+    mChunkRenderer->BeginFrame();
+    mOcclusionCuller->BeginFrame();
+    mChunkCuller.Cull(frustum, camera.GetPosition(), mRenderDistance, mVisibleChunks);
+    mCaveCuller.Traverse(frustum, camera.GetPosition(), mRenderDistance, *mChunkManager);
+    // Columns outside the frustum, those left with no section inside are counted further down
+    chunksCulled =
+        mChunkCuller.GetStats().columnsInRange - static_cast<int>(mVisibleChunks.size());
+
+    // Gather the tight bounds of the sections of every column that is not fully inside, so they can
+    // all be tested against the frustum in one batch
+    mSectionBatch.Clear();
+    mDrawCandidates.clear();
+    for (const auto& [chunkCoords, d2, fullyInside] : mVisibleChunks) {
+      if (auto renderMesh = mChunkManager->FindRenderMesh(chunkCoords); renderMesh) {
+        const glm::vec3 chunkOrigin(
+            chunkCoords.x * ChunkData::ChunkSize.x, 0, chunkCoords.z * ChunkData::ChunkSize.z);
+        DrawCandidate candidate{.renderMesh  = renderMesh,
+                                .coords      = chunkCoords,
+                                .firstBox    = mSectionBatch.Size(),
+                                .fullyInside = fullyInside};
+        const uint32_t  reachableSections = mCaveCuller.GetVisibleSections(chunkCoords);
+        for (int s = 0; s < ChunkData::SectionCount; ++s) {
+          const auto& section = renderMesh->GetSections()[s];
+          if (section.indexCount == 0) continue;
+          if (!(reachableSections & (1u << s))) {
+            ++sectionsHidden;
+            continue;
+          }
+          candidate.sections |= 1u << s;
+          if (!fullyInside) {
+            mSectionBatch.Add(
+                {chunkOrigin + glm::vec3(section.min), chunkOrigin + glm::vec3(section.max)});
+          }
+        }
+        mDrawCandidates.push_back(candidate);
 
-      const AABB aabb{
-          {x * Chunk::ChunkSize.x, 0.0f, z * Chunk::ChunkSize.z},
-          {(x + 1) * Chunk::ChunkSize.x, Chunk::ChunkSize.y, (z + 1) * Chunk::ChunkSize.z}};
+        const bool lodChanged =
+            mChunkManager->SelectLod(chunkCoords, renderMesh->GetLod()) != renderMesh->GetLod();
+        if (lodChanged ||
+            (!renderMesh->HasBeenOptimized() && d2 < mRenderDistance * mRenderDistance * 0.25f)) {
+          mChunkManager->LoadChunk(chunkCoords, ChunkManager::ChunkLoadingPriority::Optimize);
+        }
+      } else if (mChunkManager->FindChunk(chunkCoords)) {
+        mChunkManager->LoadChunk(chunkCoords, ChunkManager::ChunkLoadingPriority::Upload);
+      } else {
+        mChunkManager->LoadChunk(chunkCoords, ChunkManager::ChunkLoadingPriority::Generate);
+      }
+    }
 
-      if (frustum.IsOutside(aabb)) {
+    frustum.CullBatch(mSectionBatch, mSectionVisibility);
+
+    for (const auto& [renderMesh, chunkCoords, firstBox, sections, fullyInside] : mDrawCandidates) {
+      uint32_t visibleSections = sections;
+      if (!fullyInside) {
+        std::size_t box = firstBox;
+        for (int s = 0; s < ChunkData::SectionCount; ++s) {
+          if (!(sections & (1u << s))) continue;
+          if (!(mSectionVisibility[box / 32] & (1u << (box % 32)))) {
+            visibleSections &= ~(1u << s);
+            ++sectionsCulled;
+          }
+          ++box;
+        }
+      }
+      if (visibleSections == 0) {
         ++chunksCulled;
         continue;
       }
 
-      const ChunkCoords chunkCoords{x, z};
-      if (auto chunk = mChunkManager->FindChunk(chunkCoords); chunk) {
-        const auto chunkModel =
-            glm::translate(model, glm::vec3(x * Chunk::ChunkSize.x, 0, z * Chunk::ChunkSize.z));
-        const glm::mat4 mvp = viewProjection * chunkModel;
-
-        mChunkProgram.Use();
-        glUniformMatrix4fv(
-            mChunkProgram.GetUniformLocation("MODELVIEWPROJ"), 1, GL_FALSE, glm::value_ptr(mvp));
-        glUniformMatrix4fv(
-            mChunkProgram.GetUniformLocation("MODEL"), 1, GL_FALSE, glm::value_ptr(chunkModel));
-        glUniformMatrix4fv(mChunkProgram.GetUniformLocation("MODELVIEW"),
-                           1,
-                           GL_FALSE,
-                           glm::value_ptr(view * chunkModel));
-        glUniformMatrix4fv(
-            mChunkProgram.GetUniformLocation("PROJ"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniform3fv(mChunkProgram.GetUniformLocation("SKYCOLOR"), 1, glm::value_ptr(mSkyColor));
-        glUniform1f(mChunkProgram.GetUniformLocation("RENDER_DISTANCE"),
-                    static_cast<float>(mRenderDistance * Chunk::ChunkSize.z));
-        glUniform2fv(
-            mChunkProgram.GetUniformLocation("FOG_CONTROL"), 1, glm::value_ptr(mFogControl));
-
-        glUniform1f(mChunkProgram.GetUniformLocation("AGE"), time - chunk->GetCreationTime());
-
-        triangles += chunk->Draw();
-        ++chunksDrawn;
-
-        if (!chunk->HasBeenOptimized() && d2 < mRenderDistance * mRenderDistance * 0.25f) {
-          mChunkManager->LoadChunk(chunkCoords, ChunkManager::ChunkLoadingPriority::Optimize);
+      const glm::vec3 chunkOrigin(
+          chunkCoords.x * ChunkData::ChunkSize.x, 0, chunkCoords.z * ChunkData::ChunkSize.z);
+      for (int s = 0; s < ChunkData::SectionCount; ++s) {
+        if (!(visibleSections & (1u << s))) continue;
+        const auto& section = renderMesh->GetSections()[s];
+        if (mOcclusionCuller->IsOccluded(
+                {chunkOrigin + glm::vec3(section.min), chunkOrigin + glm::vec3(section.max)})) {
+          visibleSections &= ~(1u << s);
         }
-      } else {
-        mChunkManager->LoadChunk(chunkCoords, ChunkManager::ChunkLoadingPriority::Generate);
       }
+      if (visibleSections == 0) {
+        ++chunksOccluded;
+        continue;
+      }
+
+      triangles += mChunkRenderer->Add(*renderMesh, chunkCoords, visibleSections);
+      ++chunksDrawn;
     }
 
+    mChunkProgram.Use();
+    mChunkRenderer->Draw({
+        .view           = view,
+        .projection     = projection,
+        .skyColor       = mSkyColor,
+        .renderDistance = fogDistance,
+        .fogControl     = fogControl,
+        .time           = time,
+    });
+    mOcclusionCuller->CaptureDepth(mWidth, mHeight, viewProjection);
+
     mDebugDrawer->Draw(viewProjection);
 
     if (ImGui::Begin("Debug")) {
@@ -183,17 +256,72 @@ protected:
         }
         ImGui::ColorEdit3("Sky Color", glm::value_ptr(mSkyColor));
         ImGui::DragFloat2("Fog Control", glm::value_ptr(mFogControl));
-        if (ImGui::DragInt("Render Distance", &mRenderDistance, 1, 5, 35))
-          CalculateChunkIndexTable();
+        ImGui::DragInt("Render Distance", &mRenderDistance, 1, 5, 96);
+        mFarTerrain->Debug();
       }
 
       camera.Debug();
 
       if (ImGui::CollapsingHeader("Chunks")) {
         mChunkManager->Debug();
+        mChunkRenderer->Debug();
         ImGui::LabelText("Chunks Drawn", "%d", chunksDrawn);
         ImGui::LabelText("Chunks Culled", "%d", chunksCulled);
+        ImGui::LabelText("Chunks Occluded", "%d", chunksOccluded);
+        mOcclusionCuller->Debug();
+        ImGui::LabelText("Sections Hidden In Caves", "%d", sectionsHidden);
+        mCaveCuller.Debug();
+        ImGui::LabelText("Sections Culled", "%d", sectionsCulled);
+        ImGui::LabelText("Culling Nodes Visited", "%d", mChunkCuller.GetStats().nodesVisited);
+        ImGui::LabelText("Culling Plane Tests", "%d", mChunkCuller.GetStats().planeTests);
+        if (ImGui::Button("Benchmark Culling")) {
+          static constexpr int BenchmarkRenderDistance = 48;
+
+          const glm::mat4 benchmarkProjection = glm::perspective(
+              glm::radians(60.0f),
+              static_cast<float>(mWidth) / mHeight,
+              0.1f,
+              static_cast<float>((BenchmarkRenderDistance + 1) * ChunkData::ChunkSize.z));
+          mCullingBenchmark =
+              mChunkCuller.Benchmark(Frustum(glm::inverse(benchmarkProjection * view)),
+                                     camera.GetPosition(),
+                                     BenchmarkRenderDistance);
+        }
+        if (mCullingBenchmark) {
+          ImGui::LabelText("Flat Culling",
+                           "%.3fms at distance %d",
+                           mCullingBenchmark->flatMilliseconds,
+                           mCullingBenchmark->renderDistance);
+          ImGui::LabelText("Quadtree Culling",
+                           "%.3fms, %d visible",
+                           mCullingBenchmark->hierarchicalMilliseconds,
+                           mCullingBenchmark->visibleChunks);
+        }
+        if (ImGui::Button("Benchmark Section Culling")) {
+          mBatchBenchmark = mChunkCuller.BenchmarkBatch(frustum, mSectionBatch);
+        }
+        if (mBatchBenchmark) {
+          ImGui::LabelText("Per Box Culling",
+                           "%.3fms for %d sections",
+                           mBatchBenchmark->perBoxMilliseconds,
+                           mBatchBenchmark->boxes);
+          ImGui::LabelText("Batch Culling",
+                           "%.3fms, %d mismatches",
+                           mBatchBenchmark->batchMilliseconds,
+                           mBatchBenchmark->mismatches);
+        }
         ImGui::LabelText("Triangles Drawn", "%d", triangles);
+        if (ImGui::Button("Dig Around Camera")) {
+          const glm::ivec3 center(glm::floor(camera.GetPosition()));
+          for (int z = -4; z <= 4; ++z) {
+            for (int y = -4; y <= 4; ++y) {
+              for (int x = -4; x <= 4; ++x) {
+                if (x * x + y * y + z * z > 4 * 4) continue;
+                mChunkManager->SetBlockTypeAt(center + glm::ivec3{x, y, z}, BlockType::Empty);
+              }
+            }
+          }
+        }
       }
 
       if (ImGui::CollapsingHeader("Textures")) {
@@ -215,15 +343,35 @@ protected:
   }
 
 private:
-  int mWidth  = 1920;
-  int mHeight = 1080;
+  int mWidth  = 0;
+  int mHeight = 0;
 
   int mRenderDistance = 10;
 
-  ShaderProgram                    mChunkProgram;
-  std::vector<std::pair<int, int>> mChunkIndexTable;
-
-  std::unique_ptr<ChunkManager> mChunkManager;
+  ShaderProgram mChunkProgram;
+
+  ChunkCuller                                 mChunkCuller;
+  CaveCuller                                  mCaveCuller;
+  std::vector<ChunkCuller::VisibleChunk>      mVisibleChunks;
+  std::optional<ChunkCuller::BenchmarkResult> mCullingBenchmark;
+
+  // A drawable column and where the boxes of its sections start in mSectionBatch
+  struct DrawCandidate {
+    const ChunkRenderMesh* renderMesh  = nullptr;
+    ChunkCoords            coords      = {};
+    std::size_t            firstBox    = 0;
+    uint32_t               sections    = 0;
+    bool                   fullyInside = false;
+  };
+  std::vector<DrawCandidate>                       mDrawCandidates;
+  AABBBatch                                        mSectionBatch;
+  std::vector<uint32_t>                            mSectionVisibility;
+  std::optional<ChunkCuller::BatchBenchmarkResult> mBatchBenchmark;
+
+  std::unique_ptr<ChunkRenderer>   mChunkRenderer;
+  std::unique_ptr<ChunkManager>    mChunkManager;
+  std::unique_ptr<OcclusionCuller> mOcclusionCuller;
+  std::unique_ptr<FarTerrain>      mFarTerrain;
 
   std::unique_ptr<Atlas> mAtlas;
   BlockDescriptions      mBlockDescriptions;
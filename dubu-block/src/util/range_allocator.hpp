@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace dubu::block {
+
+// Hands out non-overlapping [offset, offset + size) ranges of a linear resource. Free ranges are
+// kept sorted by offset and merged with their neighbours when released, allocation is first fit.
+class RangeAllocator {
+public:
+  RangeAllocator(uint32_t capacity)
+      : mCapacity(capacity) {
+    if (capacity > 0) mFreeRanges.emplace(0, capacity);
+  }
+
+  std::optional<uint32_t> Allocate(uint32_t size) {
+    if (size == 0) return 0;
+
+    for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it) {
+      const auto [offset, freeSize] = *it;
+      if (freeSize < size) continue;
+
+      mFreeRanges.erase(it);
+      if (freeSize > size) mFreeRanges.emplace(offset + size, freeSize - size);
+      mUsed += size;
+      return offset;
+    }
+    return std::nullopt;
+  }
+
+  void Free(uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    assert(offset + size <= mCapacity);
+    mUsed -= size;
+
+    auto next = mFreeRanges.lower_bound(offset);
+    if (next != mFreeRanges.begin()) {
+      if (auto previous = std::prev(next); previous->first + previous->second == offset) {
+        offset = previous->first;
+        size += previous->second;
+        mFreeRanges.erase(previous);
+      }
+    }
+    if (next != mFreeRanges.end() && offset + size == next->first) {
+      size += next->second;
+      mFreeRanges.erase(next);
+    }
+    mFreeRanges.emplace(offset, size);
+  }
+
+  // Extends the resource, the new space is appended after the current capacity
+  void Grow(uint32_t newCapacity) {
+    assert(newCapacity >= mCapacity);
+    const uint32_t oldCapacity = mCapacity;
+    mCapacity                  = newCapacity;
+    mUsed += newCapacity - oldCapacity;
+    Free(oldCapacity, newCapacity - oldCapacity);
+  }
+
+  uint32_t    GetCapacity() const { return mCapacity; }
+  uint32_t    GetUsed() const { return mUsed; }
+  std::size_t GetFreeRangeCount() const { return mFreeRanges.size(); }
+
+private:
+  std::map<uint32_t, uint32_t> mFreeRanges;
+  uint32_t                     mCapacity = 0;
+  uint32_t                     mUsed     = 0;
+};
+
+}  // namespace dubu::block
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dubu::block {
+
+class ThreadPool {
+public:
+  using Job = std::function<void()>;
+
+  ThreadPool(std::size_t threadCount = DefaultThreadCount()) {
+    mThreads.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i) {
+      mThreads.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::scoped_lock lock(mMutex);
+      mStopping = true;
+      mJobs.clear();
+    }
+    mCondition.notify_all();
+    for (auto& thread : mThreads) {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&)            = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void Enqueue(Job job) {
+    {
+      std::scoped_lock lock(mMutex);
+      mJobs.push_back(std::move(job));
+    }
+    mCondition.notify_one();
+  }
+
+  std::size_t GetQueuedJobCount() const {
+    std::scoped_lock lock(mMutex);
+    return mJobs.size();
+  }
+  std::size_t GetBusyThreadCount() const { return mBusyThreads.load(std::memory_order_relaxed); }
+  std::size_t GetThreadCount() const { return mThreads.size(); }
+
+  static std::size_t DefaultThreadCount() {
+    // Leave one hardware thread for the render thread
+    const std::size_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+  }
+
+private:
+  void WorkerLoop() {
+    for (;;) {
+      Job job;
+      {
+        std::unique_lock lock(mMutex);
+        mCondition.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+        if (mStopping) return;
+        job = std::move(mJobs.front());
+        mJobs.pop_front();
+        mBusyThreads.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      job();
+
+      mBusyThreads.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::vector<std::thread> mThreads;
+  std::deque<Job>          mJobs;
+  mutable std::mutex       mMutex;
+  std::condition_variable  mCondition;
+  std::atomic<std::size_t> mBusyThreads = 0;
+  bool                     mStopping    = false;
+};
+
+}  // namespace dubu::block
\ No newline at end of file